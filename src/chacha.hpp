@@ -0,0 +1,212 @@
+#ifndef CHACHA_HPP
+#define CHACHA_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+    #include <immintrin.h>
+#endif
+
+// The ChaCha stream cipher as a generator for shuffles which have to be cryptographically secure,
+// e.g. lottery draws. The output is the keystream read as little endian 64-bit words, i.e. word k
+// of block b consists of the state words 2k and 2k + 1 of block b. We use the original layout with
+// a 64-bit block counter (state words 12, 13) and a 64-bit nonce (state words 14, 15).
+// Daniel J. Bernstein. 2008. ChaCha, a variant of Salsa20. https://cr.yp.to/chacha/chacha-20080128.pdf
+//
+// LANES blocks are computed together and stored lane by lane as in xoshiro256pp_simd: one register
+// per state word and 16 lanes with AVX-512 and per 8 lanes with AVX2. Without these instruction
+// sets (e.g. without -march=native) the plain loop is used. One refill yields LANES * 8 words, so
+// the shuffles only pay for the cipher and not for the calls.
+//
+// The key has to come from a secure source, e.g. std::random_device through std::seed_seq. The
+// buffer holds keystream which was not used yet, there is no key erasure after a refill.
+//
+// Only the sequential shuffles keep the full 256-bit key. The parallel shuffles and the executor
+// derive the generator of every task from a 64-bit seed (see seeded_generator), which would leave
+// at most 64 bits of entropy, so they refuse generators with is_cryptographic set.
+template<std::size_t ROUNDS, std::size_t LANES = 16>
+class chacha {
+    static_assert(ROUNDS % 2 == 0, "ChaCha uses double rounds");
+
+public:
+    using result_type = std::uint64_t;
+    using key_type = std::array<std::uint32_t, 8>;
+
+    static constexpr std::size_t WORDS_PER_BLOCK = 8;
+    static constexpr bool is_cryptographic = true;
+
+    static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    // All zero key and nonce, only useful for tests
+    chacha() : chacha(key_type {}, 0) {}
+
+    explicit chacha(const key_type &key, std::uint64_t nonce = 0, std::uint64_t counter = 0)
+        : input {SIGMA[0], SIGMA[1], SIGMA[2], SIGMA[3],
+                 key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+                 0, 0, static_cast<std::uint32_t>(nonce), static_cast<std::uint32_t>(nonce >> 32)},
+          counter(counter) {}
+
+    // The key and the nonce are taken from the seed sequence
+    template<typename SeedSeq, typename = decltype(std::declval<SeedSeq&>().generate(std::declval<std::uint32_t*>(), std::declval<std::uint32_t*>()))>
+    explicit chacha(SeedSeq &seed_sequence) {
+        std::array<std::uint32_t, 10> seeds;
+        seed_sequence.generate(seeds.begin(), seeds.end());
+        input = {SIGMA[0], SIGMA[1], SIGMA[2], SIGMA[3],
+                 seeds[0], seeds[1], seeds[2], seeds[3], seeds[4], seeds[5], seeds[6], seeds[7],
+                 0, 0, seeds[8], seeds[9]};
+    }
+
+    result_type operator()() {
+        if (index == BUFFER_WORDS) {
+            generate(buffer.data());
+            index = 0;
+        }
+        return buffer[index++];
+    }
+
+    // Writes the next n words to out. This gives the same words as n calls of operator().
+    void fill(result_type *out, std::size_t n) {
+        for (; n > 0 && index < BUFFER_WORDS; n--) {
+            *out++ = buffer[index++];
+        }
+        for (; n >= BUFFER_WORDS; n -= BUFFER_WORDS) {
+            generate(out);
+            out += BUFFER_WORDS;
+        }
+        for (; n > 0; n--) {
+            *out++ = operator()();
+        }
+    }
+
+private:
+    static constexpr std::array<std::uint32_t, 4> SIGMA = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    static constexpr std::size_t BUFFER_WORDS = LANES * WORDS_PER_BLOCK;
+
+    static std::uint32_t rotl(std::uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    // The quarter round on the lanes [begin, end) of the state words a, b, c, d
+    static void quarter_round(std::array<std::uint32_t, LANES> &a, std::array<std::uint32_t, LANES> &b,
+                              std::array<std::uint32_t, LANES> &c, std::array<std::uint32_t, LANES> &d,
+                              std::size_t begin, std::size_t end) {
+        for (std::size_t l = begin; l < end; l++) {
+            a[l] += b[l]; d[l] ^= a[l]; d[l] = rotl(d[l], 16);
+            c[l] += d[l]; b[l] ^= c[l]; b[l] = rotl(b[l], 12);
+            a[l] += b[l]; d[l] ^= a[l]; d[l] = rotl(d[l], 8);
+            c[l] += d[l]; b[l] ^= c[l]; b[l] = rotl(b[l], 7);
+        }
+    }
+
+    // Computes the blocks counter, ..., counter + LANES - 1 and writes their words to out
+    void generate(result_type *out) {
+        [[maybe_unused]] constexpr std::size_t AVX512_END = LANES / 16 * 16;
+        [[maybe_unused]] constexpr std::size_t AVX2_END = LANES / 8 * 8;
+
+        alignas(64) std::array<std::array<std::uint32_t, LANES>, 16> x;
+        for (std::size_t i = 0; i < 16; i++) {
+            x[i].fill(input[i]);
+        }
+        for (std::size_t l = 0; l < LANES; l++) {
+            std::uint64_t block = counter + l;
+            x[12][l] = static_cast<std::uint32_t>(block);
+            x[13][l] = static_cast<std::uint32_t>(block >> 32);
+        }
+        counter += LANES;
+
+        std::size_t l = 0;
+#if defined(__AVX512F__)
+        for (; l < AVX512_END; l += 16) {
+            __m512i v[16];
+            for (std::size_t i = 0; i < 16; i++) {
+                v[i] = _mm512_loadu_si512(&x[i][l]);
+            }
+            // The maskz variant with a full mask avoids -Wuninitialized false positives of GCC 12
+            auto qr = [&](int a, int b, int c, int d) {
+                v[a] = _mm512_add_epi32(v[a], v[b]); v[d] = _mm512_maskz_rol_epi32(0xffff, _mm512_xor_si512(v[d], v[a]), 16);
+                v[c] = _mm512_add_epi32(v[c], v[d]); v[b] = _mm512_maskz_rol_epi32(0xffff, _mm512_xor_si512(v[b], v[c]), 12);
+                v[a] = _mm512_add_epi32(v[a], v[b]); v[d] = _mm512_maskz_rol_epi32(0xffff, _mm512_xor_si512(v[d], v[a]), 8);
+                v[c] = _mm512_add_epi32(v[c], v[d]); v[b] = _mm512_maskz_rol_epi32(0xffff, _mm512_xor_si512(v[b], v[c]), 7);
+            };
+            for (std::size_t r = 0; r < ROUNDS; r += 2) {
+                qr(0, 4, 8, 12); qr(1, 5, 9, 13); qr(2, 6, 10, 14); qr(3, 7, 11, 15);
+                qr(0, 5, 10, 15); qr(1, 6, 11, 12); qr(2, 7, 8, 13); qr(3, 4, 9, 14);
+            }
+            for (std::size_t i = 0; i < 16; i++) {
+                __m512i initial = _mm512_loadu_si512(&x[i][l]);
+                _mm512_storeu_si512(&x[i][l], _mm512_add_epi32(v[i], initial));
+            }
+        }
+#endif
+#if defined(__AVX2__)
+        // AVX2 has no 32-bit rotation, the rotations by 16 and 8 are byte shuffles
+        const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                               2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+        const __m256i rot8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                              3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+        auto rotl256 = [](__m256i y, int k) {
+            return _mm256_or_si256(_mm256_slli_epi32(y, k), _mm256_srli_epi32(y, 32 - k));
+        };
+        for (; l < AVX2_END; l += 8) {
+            __m256i v[16];
+            for (std::size_t i = 0; i < 16; i++) {
+                v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&x[i][l]));
+            }
+            auto qr = [&](int a, int b, int c, int d) {
+                v[a] = _mm256_add_epi32(v[a], v[b]); v[d] = _mm256_shuffle_epi8(_mm256_xor_si256(v[d], v[a]), rot16);
+                v[c] = _mm256_add_epi32(v[c], v[d]); v[b] = rotl256(_mm256_xor_si256(v[b], v[c]), 12);
+                v[a] = _mm256_add_epi32(v[a], v[b]); v[d] = _mm256_shuffle_epi8(_mm256_xor_si256(v[d], v[a]), rot8);
+                v[c] = _mm256_add_epi32(v[c], v[d]); v[b] = rotl256(_mm256_xor_si256(v[b], v[c]), 7);
+            };
+            for (std::size_t r = 0; r < ROUNDS; r += 2) {
+                qr(0, 4, 8, 12); qr(1, 5, 9, 13); qr(2, 6, 10, 14); qr(3, 7, 11, 15);
+                qr(0, 5, 10, 15); qr(1, 6, 11, 12); qr(2, 7, 8, 13); qr(3, 4, 9, 14);
+            }
+            for (std::size_t i = 0; i < 16; i++) {
+                __m256i initial = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&x[i][l]));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&x[i][l]), _mm256_add_epi32(v[i], initial));
+            }
+        }
+#endif
+        if (l < LANES) {
+            alignas(64) std::array<std::array<std::uint32_t, LANES>, 16> initial = x;
+            for (std::size_t r = 0; r < ROUNDS; r += 2) {
+                quarter_round(x[0], x[4], x[8], x[12], l, LANES);
+                quarter_round(x[1], x[5], x[9], x[13], l, LANES);
+                quarter_round(x[2], x[6], x[10], x[14], l, LANES);
+                quarter_round(x[3], x[7], x[11], x[15], l, LANES);
+                quarter_round(x[0], x[5], x[10], x[15], l, LANES);
+                quarter_round(x[1], x[6], x[11], x[12], l, LANES);
+                quarter_round(x[2], x[7], x[8], x[13], l, LANES);
+                quarter_round(x[3], x[4], x[9], x[14], l, LANES);
+            }
+            for (std::size_t i = 0; i < 16; i++) {
+                for (std::size_t k = l; k < LANES; k++) {
+                    x[i][k] += initial[i][k];
+                }
+            }
+        }
+
+        // Back from lanes to blocks
+        for (std::size_t b = 0; b < LANES; b++) {
+            for (std::size_t k = 0; k < WORDS_PER_BLOCK; k++) {
+                out[b * WORDS_PER_BLOCK + k] = static_cast<std::uint64_t>(x[2*k][b]) | (static_cast<std::uint64_t>(x[2*k + 1][b]) << 32);
+            }
+        }
+    }
+
+    std::array<std::uint32_t, 16> input;
+    // Index of the next block
+    std::uint64_t counter = 0;
+    std::array<result_type, BUFFER_WORDS> buffer;
+    std::size_t index = BUFFER_WORDS;
+};
+
+using chacha20 = chacha<20>;
+using chacha12 = chacha<12>;
+
+#endif /* CHACHA_HPP */
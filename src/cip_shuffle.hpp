@@ -8,6 +8,26 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <bit>
+#include <tuple>
+#include <utility>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/syscall.h>
+#endif
 
 #ifdef LOG_NUM_BUCKETS_VAR
     constexpr std::size_t LOG_NUM_BUCKETS = LOG_NUM_BUCKETS_VAR;
@@ -33,20 +53,182 @@
     constexpr std::size_t LOG_BUFFER_THRESHOLD = 20;   // Default is 18; 8, 12, 18
 #endif
 
+#ifdef LOG_MAX_STRIPES_VAR
+    constexpr std::size_t LOG_MAX_STRIPES = LOG_MAX_STRIPES_VAR;
+#else
+    constexpr std::size_t LOG_MAX_STRIPES = 6;   // Independent of the number of threads, see scatter_shuffle_task
+#endif
+
+#ifdef LOG_PARALLEL_THRESHOLD_VAR
+    constexpr std::size_t LOG_PARALLEL_THRESHOLD = LOG_PARALLEL_THRESHOLD_VAR;
+#else
+    constexpr std::size_t LOG_PARALLEL_THRESHOLD = 22;   // Below this size we do not spawn any threads
+#endif
+
+#ifdef LOG_MIN_NUM_BUCKETS_VAR
+    constexpr std::size_t LOG_MIN_NUM_BUCKETS = LOG_MIN_NUM_BUCKETS_VAR;
+#else
+    constexpr std::size_t LOG_MIN_NUM_BUCKETS = LOG_NUM_BUCKETS > 1 ? LOG_NUM_BUCKETS - 1 : 1;   // Fewest buckets of a level, see choose_log_num_buckets
+#endif
+
+#ifdef LOG_MAX_NUM_BUCKETS_VAR
+    constexpr std::size_t LOG_MAX_NUM_BUCKETS = LOG_MAX_NUM_BUCKETS_VAR;
+#else
+    constexpr std::size_t LOG_MAX_NUM_BUCKETS = LOG_NUM_BUCKETS + 1;   // Most buckets of a level, see choose_log_num_buckets
+#endif
+
+#ifdef LOG_PREFETCH_DISTANCE_VAR
+    constexpr std::size_t LOG_PREFETCH_DISTANCE = LOG_PREFETCH_DISTANCE_VAR;
+#else
+    constexpr std::size_t LOG_PREFETCH_DISTANCE = 3;   // Bucket indices which prefetching_rough_scatter decodes ahead, at most 64 bits of them
+#endif
+
+#ifdef ROUGH_SCATTER_KERNEL_VAR
+    constexpr std::size_t ROUGH_SCATTER_KERNEL = ROUGH_SCATTER_KERNEL_VAR;
+#else
+    constexpr std::size_t ROUGH_SCATTER_KERNEL = 0;   // Rough scatter of the levels beyond the last cache, see large_rough_scatter
+#endif
+
+#ifdef LOG_SCATTER_BLOCK_SIZE_VAR
+    constexpr std::size_t LOG_SCATTER_BLOCK_SIZE = LOG_SCATTER_BLOCK_SIZE_VAR;
+#else
+    constexpr std::size_t LOG_SCATTER_BLOCK_SIZE = 3;   // Items per block of block_rough_scatter, 8 items of 8 bytes are a cache line
+#endif
+
+#ifdef LOG_REBALANCE_PIECE_SIZE_VAR
+    constexpr std::size_t LOG_REBALANCE_PIECE_SIZE = LOG_REBALANCE_PIECE_SIZE_VAR;
+#else
+    constexpr std::size_t LOG_REBALANCE_PIECE_SIZE = 16;    // Items per task of a wave of the parallel rebalance, smaller waves are not worth splitting
+#endif
+
 constexpr std::size_t NUM_BUCKETS = 1 << LOG_NUM_BUCKETS;
 constexpr std::size_t BUFFER_SIZE = 1 << LOG_BUFFER_SIZE; 
 constexpr std::size_t THRESHOLD = 1 << LOG_THRESHOLD;
 constexpr std::size_t BUFFER_THRESHOLD = 1 << LOG_BUFFER_THRESHOLD;
+constexpr std::size_t PARALLEL_THRESHOLD = 1 << LOG_PARALLEL_THRESHOLD;
+constexpr std::size_t MAX_STRIPES = 1 << LOG_MAX_STRIPES;
+constexpr std::size_t PREFETCH_DISTANCE = 1 << LOG_PREFETCH_DISTANCE;
+constexpr std::size_t SCATTER_BLOCK_SIZE = 1 << LOG_SCATTER_BLOCK_SIZE;
+constexpr std::size_t REBALANCE_PIECE_SIZE = 1 << LOG_REBALANCE_PIECE_SIZE;
+
+// Bucket as data structure. Index is the type of the positions, inplace_scatter_shuffle uses 
+// std::uint32_t for subproblems with less than 2^32 items, which halves the size of the buckets.
+template<typename Index>
+struct basic_bucket_limits {
+    Index begin;
+    Index staged;
+    Index end;
+
+    Index num_total() { return end - begin; }
+    Index num_placed() { return staged - begin; } 
+    Index num_staged() { return end - staged; } 
+};
+
+using bucket_limits = basic_bucket_limits<std::size_t>;
+
+// Generators whose words are uniform from [0, 2^64) and [0, 2^32), e.g. pcg64 or std::mt19937_64 
+// and pcg32 or std::mt19937
+template<typename RNG>
+concept random_generator_64 = std::uniform_random_bit_generator<RNG> 
+                              && RNG::min() == 0 && RNG::max() == std::numeric_limits<std::uint64_t>::max();
 
-// Bucket as data structure
-struct bucket_limits {
-    std::size_t begin;
-    std::size_t staged;
-    std::size_t end;
+template<typename RNG>
+concept random_generator_32 = std::uniform_random_bit_generator<RNG> 
+                              && RNG::min() == 0 && RNG::max() == std::numeric_limits<std::uint32_t>::max();
+
+// Number of uniform bits which we take from one word of RNG. If the range of RNG is not a power of 
+// two (e.g. std::minstd_rand) we only take the values below the largest power of two in it.
+template<std::uniform_random_bit_generator RNG>
+constexpr std::size_t generator_bits() {
+    constexpr std::uint64_t range = static_cast<std::uint64_t>(RNG::max() - RNG::min());
+    if constexpr (range == std::numeric_limits<std::uint64_t>::max()) {
+        return 64;
+    } else {
+        return std::bit_width(range + 1) - 1;
+    }
+}
+
+// Takes generator_bits<RNG>() uniform bits from gen
+template<std::uniform_random_bit_generator RNG>
+std::uint64_t uniform_bits(RNG &gen) {
+    constexpr std::size_t BITS = generator_bits<RNG>();
+    if constexpr (BITS == 64) {
+        return static_cast<std::uint64_t>(gen() - RNG::min());
+    } else {
+        constexpr std::uint64_t limit = std::uint64_t(1) << BITS;
+        while (true) {
+            std::uint64_t x = static_cast<std::uint64_t>(gen() - RNG::min());
+            if (x < limit) {
+                return x;
+            }
+        }
+    }
+}
+
+// A uniform 64-bit word from any generator. For 64-bit generators this is just gen() and for 
+// 32-bit generators two words of gen are concatenated, all decided at compile time.
+template<std::uniform_random_bit_generator RNG>
+std::uint64_t random_word_64(RNG &gen) {
+    if constexpr (random_generator_64<RNG>) {
+        return gen();
+    } else if constexpr (random_generator_32<RNG>) {
+        std::uint64_t high = gen();
+        return (high << 32) | gen();
+    } else {
+        constexpr std::size_t BITS = generator_bits<RNG>();
+        static_assert(BITS > 0, "The generator has to produce at least one random bit");
+        std::uint64_t x = 0;
+        for (std::size_t bits = 0; bits < 64; bits += BITS) {
+            x = (x << BITS) | uniform_bits(gen);
+        }
+        return x;
+    }
+}
 
-    std::size_t num_total() { return end - begin; }
-    std::size_t num_placed() { return staged - begin; } 
-    std::size_t num_staged() { return end - staged; } 
+// A uniform 32-bit word from any generator, which costs one word of gen if it has at least 32 bits
+template<std::uniform_random_bit_generator RNG>
+std::uint32_t random_word_32(RNG &gen) {
+    if constexpr (generator_bits<RNG>() >= 32) {
+        return static_cast<std::uint32_t>(uniform_bits(gen));
+    } else {
+        return static_cast<std::uint32_t>(random_word_64(gen));
+    }
+}
+
+// The consumers of single bits (rough_scatter, merge_shuffled_blocks) use the words of 32-bit 
+// generators as they are and everything else as 64-bit words
+template<std::uniform_random_bit_generator RNG>
+constexpr std::size_t random_word_bits = random_generator_32<RNG> ? 32 : 64;
+
+template<std::uniform_random_bit_generator RNG>
+std::uint64_t random_word(RNG &gen) {
+    if constexpr (random_word_bits<RNG> == 32) {
+        return gen();
+    } else {
+        return random_word_64(gen);
+    }
+}
+
+// Turns any uniform random bit generator into a generator of uniform 64-bit words. All functions 
+// of this header take any generator directly, the adapter is for code which needs 64-bit words 
+// itself. For generators which already are 64-bit use them directly.
+template<std::uniform_random_bit_generator RNG>
+class rng_adapter {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit rng_adapter(RNG &gen) : gen(gen) {}
+
+    result_type operator()() { return random_word_64(gen); }
+
+    // 32 bits with a single word of 32-bit generators
+    std::uint32_t next_32() { return random_word_32(gen); }
+
+private:
+    RNG &gen;
 };
 
 // Note taht gen is a 64-bit generator.
@@ -56,13 +238,13 @@ template<typename RNG>
 std::uint32_t my_uniform_int_distribution_32(std::uint32_t s, RNG &gen) {
     // This should generate a 64 Bit word using any generator. We 
     // save it as a 32 Bit word. s should be random from [0, 2^32).
-    std::uint32_t x = static_cast<uint32_t>(gen());
+    std::uint32_t x = random_word_32(gen);
     std::uint64_t m = static_cast<std::uint64_t>(x) * static_cast<std::uint64_t>(s);
     std::uint32_t l = std::uint32_t(m);
     if (l < s) {
         std::uint32_t t = -s % s;
         while (l < t) {
-            x = static_cast<uint32_t>(gen());
+            x = random_word_32(gen);
             std::uint64_t m = static_cast<std::uint64_t>(x) * static_cast<std::uint64_t>(s);
             l = std::uint32_t(m);
         }
@@ -78,13 +260,13 @@ template<typename RNG>
 std::uint64_t my_uniform_int_distribution_64(std::uint64_t s, RNG &gen) {
     // This should generate a 64 Bit word using any generator. We 
     // save it as a 64 Bit word. s should be random from [0, 2^64).
-    std::uint64_t x = gen();
+    std::uint64_t x = random_word_64(gen);
     __uint128_t m = static_cast<__uint128_t>(x) * static_cast<__uint128_t>(s);
     std::uint64_t l = std::uint64_t(m);
     if (l < s) {
         std::uint64_t t = -s % s;
         while (l < t) {
-            x = gen();
+            x = random_word_64(gen);
             __uint128_t m = static_cast<__uint128_t>(x) * static_cast<__uint128_t>(s);
             l = std::uint64_t(m);
         }
@@ -92,6 +274,110 @@ std::uint64_t my_uniform_int_distribution_64(std::uint64_t s, RNG &gen) {
     return m >> 64;
 }
 
+// Samples from [0, bound), [0, bound - 1), ..., [0, bound - K + 1) out of a single 64-bit word. 
+// Each multiplication by a bound consumes the high bits of the previous product as in 
+// my_uniform_int_distribution_64, and the rejection is done once for the product of the bounds, 
+// which must fit into 64 bits. The result is the same as K unbiased calls but with one call of 
+// gen in the common case.
+// Nevin Brackett-Rozinsky and Daniel Lemire. 2024. Batched Ranged Random Integer Generation. Software: Practice and Experience 55, 1, 155-169. https://doi.org/10.1002/spe.3369
+template<std::size_t K, typename RNG>
+std::array<std::uint64_t, K> batched_uniform_int_distribution(std::uint64_t bound, RNG &gen) {
+    std::array<std::uint64_t, K> result;
+    std::uint64_t leftover;
+    auto draw = [&]() {
+        leftover = random_word_64(gen);
+        for (std::size_t k = 0; k < K; k++) {
+            __uint128_t m = static_cast<__uint128_t>(leftover) * static_cast<__uint128_t>(bound - k);
+            result[k] = static_cast<std::uint64_t>(m >> 64);
+            leftover = static_cast<std::uint64_t>(m);
+        }
+    };
+    draw();
+
+    std::uint64_t product = bound;
+    for (std::size_t k = 1; k < K; k++) {
+        product *= bound - k;
+    }
+    if (leftover < product) {
+        std::uint64_t t = -product % product;
+        while (leftover < t) {
+            draw();
+        }
+    }
+    return result;
+}
+
+// Same as above for out.size() samples from [0, bound), [0, bound - 1), ... The product of the 
+// bounds must fit into 64 bits.
+template<typename RNG>
+void batched_uniform_int_distribution(std::uint64_t bound, std::span<std::size_t> out, RNG &gen) {
+    std::uint64_t leftover;
+    auto draw = [&]() {
+        leftover = random_word_64(gen);
+        for (std::size_t k = 0; k < out.size(); k++) {
+            __uint128_t m = static_cast<__uint128_t>(leftover) * static_cast<__uint128_t>(bound - k);
+            out[k] = static_cast<std::size_t>(m >> 64);
+            leftover = static_cast<std::uint64_t>(m);
+        }
+    };
+    draw();
+
+    std::uint64_t product = 1;
+    for (std::size_t k = 0; k < out.size(); k++) {
+        product *= bound - k;
+    }
+    if (leftover < product) {
+        std::uint64_t t = -product % product;
+        while (leftover < t) {
+            draw();
+        }
+    }
+}
+
+// Largest bounds for which we draw 4, 3 and 2 samples from one 64-bit word. The products of the 
+// bounds stay below 2^60, hence a redraw is rare. Below BATCH_ALL_BOUND all remaining samples 
+// come from one word, 18! < 2^53.
+constexpr std::uint64_t BATCH_ALL_BOUND = 18;
+constexpr std::uint64_t BATCH_4_BOUND = std::uint64_t(1) << 14;
+constexpr std::uint64_t BATCH_3_BOUND = std::uint64_t(1) << 19;
+constexpr std::uint64_t BATCH_2_BOUND = std::uint64_t(1) << 30;
+
+// Writes K samples from [0, bound), ..., [0, bound - K + 1) to out
+template<std::size_t K, typename RNG>
+void batched_indices_step(std::uint64_t bound, std::size_t *out, RNG &gen) {
+    auto j = batched_uniform_int_distribution<K>(bound, gen);
+    for (std::size_t k = 0; k < K; k++) {
+        out[k] = j[k];
+    }
+}
+
+// Writes samples from [0, bound), [0, bound - 1), ... to out, each bound must be positive. As the 
+// bounds decrease we switch to larger batches.
+template<typename RNG>
+void batched_indices(std::uint64_t bound, std::span<std::size_t> out, RNG &gen) {
+    std::size_t k = 0;
+    const std::size_t n = out.size();
+    for (; k < n && bound - k > BATCH_2_BOUND; k++) {
+        out[k] = my_uniform_int_distribution_64(bound - k, gen);
+    }
+    for (; k + 2 <= n && bound - k > BATCH_3_BOUND; k += 2) {
+        batched_indices_step<2>(bound - k, &out[k], gen);
+    }
+    for (; k + 3 <= n && bound - k > BATCH_4_BOUND; k += 3) {
+        batched_indices_step<3>(bound - k, &out[k], gen);
+    }
+    for (; k + 4 <= n && bound - k > BATCH_ALL_BOUND; k += 4) {
+        batched_indices_step<4>(bound - k, &out[k], gen);
+    }
+    if (k < n && bound - k <= BATCH_ALL_BOUND) {
+        batched_uniform_int_distribution(bound - k, out.subspan(k), gen);
+        return;
+    }
+    for (; k < n; k++) {
+        out[k] = my_uniform_int_distribution_64(bound - k, gen);
+    }
+}
+
 // A simple Fisher-Yates implementation
 template<typename T, typename RNG>
 void fisher_yates_shuffle(std::span<T> data_span, RNG &gen) {
@@ -107,17 +393,48 @@ void fisher_yates_shuffle(std::span<T> data_span, RNG &gen) {
     }
 }
 
-// A simple Fisher-Yates implementation with our own 32-bit uniform_int_distribution
+// K steps of Fisher-Yates at positions i, ..., i - K + 1 with the indices of one batch
+template<std::size_t K, typename T, typename RNG>
+void fisher_yates_steps(std::span<T> data_span, std::size_t i, RNG &gen) {
+    // uniform samples from [0, i+1), [0, i), ...
+    auto j = batched_uniform_int_distribution<K>(i + 1, gen);
+    for (std::size_t k = 0; k < K; k++) {
+        using std::swap;
+        swap(data_span[i - k], data_span[j[k]]);
+    }
+}
+
+// A simple Fisher-Yates implementation with our own batched uniform_int_distribution. Up to four 
+// indices come from one word of gen, see batched_uniform_int_distribution.
 template<typename T, typename RNG>
 void fisher_yates_shuffle_32(std::span<T> data_span, RNG &gen) {
-    if (!data_span.empty()) {
-        for (std::size_t i = data_span.size() - 1; i > 0; i--) {
-            // uniform sample from [0, i+1)
-            std::size_t j = my_uniform_int_distribution_32(i + 1, gen);
-
+    if (data_span.empty()) {
+        return;
+    }
+    std::size_t i = data_span.size() - 1;
+    for (; i >= 1 && i + 1 > BATCH_2_BOUND; i--) {
+        fisher_yates_steps<1>(data_span, i, gen);
+    }
+    for (; i >= 2 && i + 1 > BATCH_3_BOUND; i -= 2) {
+        fisher_yates_steps<2>(data_span, i, gen);
+    }
+    for (; i >= 3 && i + 1 > BATCH_4_BOUND; i -= 3) {
+        fisher_yates_steps<3>(data_span, i, gen);
+    }
+    for (; i >= 4 && i + 1 > BATCH_ALL_BOUND; i -= 4) {
+        fisher_yates_steps<4>(data_span, i, gen);
+    }
+    if (i + 1 <= BATCH_ALL_BOUND && i > 0) {
+        std::array<std::size_t, BATCH_ALL_BOUND> j;
+        batched_uniform_int_distribution(i + 1, std::span {j}.first(i), gen);
+        for (std::size_t k = 0; k < i; k++) {
             using std::swap;
-            swap(data_span[i], data_span[j]);
+            swap(data_span[i - k], data_span[j[k]]);
         }
+        return;
+    }
+    for (; i > 0; i--) {
+        fisher_yates_steps<1>(data_span, i, gen);
     }
 }
 
@@ -135,7 +452,8 @@ void fisher_yates_shuffle_64(std::span<T> data_span, RNG &gen) {
     }
 }
 
-// Buffered version of Fisher-Yates as in Daniel Lemire's paper.
+// Buffered version of Fisher-Yates as in Daniel Lemire's paper. The buffer is filled with 
+// batched_indices.
 // Daniel Lemire. 2019. Fast Random Integer Generation in an Interval. ACM Trans. Model. Comput. Simul. 29, 1, Article 3 (January 2019), 12 pages. https://doi.org/10.1145/3230636
 template<typename T, typename RNG>
 void buffered_fisher_yates_shuffle_32(std::span<T> data_span, RNG &gen) {
@@ -143,20 +461,18 @@ void buffered_fisher_yates_shuffle_32(std::span<T> data_span, RNG &gen) {
     std::array<std::size_t, BUFFER_SIZE> buffer{};
 
     for (; i >= BUFFER_SIZE; i -= BUFFER_SIZE) {
-        for (std::size_t k = 0; k < BUFFER_SIZE; k++) {
-            std::size_t j = my_uniform_int_distribution_32(static_cast<uint32_t>(i - k + 1), gen);
-            buffer[k] = j;
-        }
+        batched_indices(i + 1, std::span {buffer}, gen);
         for (std::size_t k = 0; k < BUFFER_SIZE; k++) {
             using std::swap;
             swap(data_span[i - k], data_span[buffer[k]]);
         }
     }
-    while (i > 0) {
-        std::size_t j = my_uniform_int_distribution_32(static_cast<uint32_t>(i + 1), gen);
-        using std::swap;
-        swap(data_span[i], data_span[j]);
-        i--;
+    if (i > 0) {
+        batched_indices(i + 1, std::span {buffer}.first(i), gen);
+        for (std::size_t k = 0; k < i; k++) {
+            using std::swap;
+            swap(data_span[i - k], data_span[buffer[k]]);
+        }
     }
 }
 
@@ -200,25 +516,35 @@ void buffered_fisher_yates_shuffle(std::span<T> data_span, RNG &gen) {
 
 // A noncontinuous variant of the fisher-yates shuffle algorithm. The works basically like the 
 // fisher-yates shuffle algorithm but we use the additional information given from the bucekts
-// to calcualte some offset value to reach the noncontinuous staged sections in the data_span.
-template<size_t K, typename T, typename RNG> 
-void noncontinuous_fisher_yates_shuffle(std::span<T> data_span, std::array<bucket_limits, K> &buckets, RNG &gen) {
+// to calcualte some offset value to reach the noncontinuous staged sections in the data_span. 
+// The random indices are drawn in batches as in buffered_fisher_yates_shuffle_32, small nodes 
+// take this path for most of their stashes.
+template<size_t K, typename T, typename RNG, typename Index> 
+void noncontinuous_fisher_yates_shuffle(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
     if (data_span.empty()) {
         return; 
     }
 
     // At index i we store the total number of staged items left of bucket i, 
     // basically an exclusive prefix sum of the staged items.
-    std::array<size_t, K> num_staged_items_left {};
+    std::array<Index, K> num_staged_items_left {};
     for (std::size_t i = 1; i < K; i++) {
         num_staged_items_left[i] = num_staged_items_left[i - 1] + buckets[i - 1].num_staged();
     }
 
     // Total amount of staged items
-    std::size_t stash_size = num_staged_items_left[K - 1] + buckets[K - 1].num_staged();
+    Index stash_size = num_staged_items_left[K - 1] + buckets[K - 1].num_staged();
 
-    for (std::size_t index = stash_size - 1; index > 0; index--) {
-        std::size_t random_index = my_uniform_int_distribution_64(index + 1, gen);
+    std::array<std::size_t, BUFFER_SIZE> random_indices {};
+    std::size_t next = 0;
+    std::size_t filled = 0;
+    for (Index index = stash_size - 1; index > 0; index--) {
+        if (next == filled) {
+            filled = std::min<std::size_t>(BUFFER_SIZE, index);
+            batched_indices(index + 1, std::span {random_indices}.first(filled), gen);
+            next = 0;
+        }
+        Index random_index = static_cast<Index>(random_indices[next++]);
 
         // We search for the bucket which contains the index-th staged item
         std::size_t bucket_num_index = 0;
@@ -241,12 +567,12 @@ void noncontinuous_fisher_yates_shuffle(std::span<T> data_span, std::array<bucke
         }
         
         // We map index to the actual location in the data_span
-        std::size_t offset_i = index - num_staged_items_left[bucket_num_index];
-        std::size_t i = buckets[bucket_num_index].staged + offset_i;
+        Index offset_i = index - num_staged_items_left[bucket_num_index];
+        Index i = buckets[bucket_num_index].staged + offset_i;
 
         // We map random_index to the actual location in the data_span
-        std::size_t offset_j = random_index - num_staged_items_left[bucket_num_random_index];
-        std::size_t j = buckets[bucket_num_random_index].staged + offset_j;
+        Index offset_j = random_index - num_staged_items_left[bucket_num_random_index];
+        Index j = buckets[bucket_num_random_index].staged + offset_j;
 
         using std::swap;
         swap(data_span[i], data_span[j]);
@@ -257,8 +583,8 @@ void noncontinuous_fisher_yates_shuffle(std::span<T> data_span, std::array<bucke
 // A function which puts the staged items into one continuous segment.
 // Ideally the staged items will fit into one bucket.
 // This code is based on the implemenation in https://github.com/manpen/rip_shuffle?tab=readme-ov-file
-template<size_t K, typename T, typename RNG> 
-void shuffle_stashes(std::span<T> data_span, std::array<bucket_limits, K> &buckets, RNG &gen) {
+template<size_t K, typename T, typename RNG, typename Index> 
+void shuffle_stashes(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
     size_t stash_size = 0;
     for (auto& bucket : buckets) {
         stash_size += bucket.num_staged();
@@ -278,11 +604,11 @@ void shuffle_stashes(std::span<T> data_span, std::array<bucket_limits, K> &bucke
 
 // Helper function. 
 // This code is based on the implemenation in https://github.com/manpen/rip_shuffle?tab=readme-ov-file
-template<size_t K, typename T> 
-void compact_stashes(std::span<T> data_span, std::array<bucket_limits, K> &buckets, size_t stash_size) {
+template<size_t K, typename T, typename Index> 
+void compact_stashes(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, size_t stash_size) {
     size_t remaining_items = stash_size;
     for (size_t i = 0; i < K - 1; i++) {
-        bucket_limits bucket = buckets[i];
+        basic_bucket_limits<Index> bucket = buckets[i];
         std::swap_ranges(data_span.begin() + bucket.staged, 
                          data_span.begin() + bucket.end, 
                          data_span.end() - remaining_items);
@@ -296,7 +622,7 @@ template<typename T, size_t K, typename RNG>
 void uniform_n_bit_numbners(std::size_t n, std::array<T, K>& buffer, RNG &gen) {
     std::uint64_t bitmask = (1UL << n) - 1;
 
-    std::uint64_t x = gen();
+    std::uint64_t x = random_word_64(gen);
     for (std::size_t i = 0; i < buffer.size(); i++) {
         std::uint64_t chunk = static_cast<std::uint64_t>(x & bitmask); // Extract the lowest n bits
         buffer[i] = chunk;
@@ -304,27 +630,51 @@ void uniform_n_bit_numbners(std::size_t n, std::array<T, K>& buffer, RNG &gen) {
     }
 }
 
+// The next bucket index of the rough scatters: the low LOG_K bits of random_bits, which holds 
+// bits_left random bits. If fewer are left, they are the low bits of the index and the rest comes 
+// from the next word of gen, so every bit of gen is used.
+template<std::size_t LOG_K, typename RNG>
+inline std::uint64_t next_bucket_index(std::uint64_t &random_bits, std::size_t &bits_left, RNG &gen) {
+    constexpr std::uint64_t bitmask = (std::uint64_t(1) << LOG_K) - 1;
+    if (bits_left >= LOG_K) {
+        std::uint64_t j = random_bits & bitmask;
+        random_bits = random_bits >> LOG_K;
+        bits_left -= LOG_K;
+        return j;
+    }
+    std::uint64_t word = random_word(gen);
+    std::uint64_t j = (random_bits | (word << bits_left)) & bitmask;
+    const std::size_t taken = LOG_K - bits_left;
+    random_bits = word >> taken;
+    bits_left = random_word_bits<RNG> - taken;
+    return j;
+}
+
 // Rough Scatter
-template<std::size_t K, typename T, typename RNG>
-void rough_scatter(std::span<T> data_span, std::array<bucket_limits, K> &buckets, RNG &gen) {
-    // bitmask to get lower bits 
-    constexpr std::uint64_t bitmask = (1UL << LOG_NUM_BUCKETS) - 1;
+template<std::size_t K, typename T, typename RNG, typename Index>
+void rough_scatter(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
+    static_assert(std::has_single_bit(K), "The number of buckets has to be a power of two");
+    constexpr std::size_t LOG_K = std::bit_width(K) - 1;
 
     // counter which shows how many bits are left
-    std::size_t bits_left = 64;
+    std::size_t bits_left = 0;
     // bits will hold 
-    std::uint64_t random_bits = gen();
+    std::uint64_t random_bits = 0;
+    // A bit_reservoir hands over the bits left over by the previous phase. They are kept in local 
+    // variables, the stores into data_span could alias the reservoir.
+    constexpr bool from_reservoir = requires { gen.take_available(); };
+    if constexpr (from_reservoir) {
+        std::tie(random_bits, bits_left) = gen.take_available();
+    }
 
     while (true) {
         // We generate a new random index from random_bits
-        std::uint64_t j = static_cast<std::uint64_t>(random_bits & bitmask);
-        random_bits = random_bits >> LOG_NUM_BUCKETS;
-        bits_left -= LOG_NUM_BUCKETS;
+        std::uint64_t j = next_bucket_index<LOG_K>(random_bits, bits_left, gen);
 
         if (j != 0) {
             using std::swap;
-            std::size_t s_0 = buckets[0].staged;
-            std::size_t s_j = buckets[j].staged;
+            Index s_0 = buckets[0].staged;
+            Index s_j = buckets[j].staged;
             swap(data_span[s_0], data_span[s_j]);
         }
 
@@ -333,18 +683,377 @@ void rough_scatter(std::span<T> data_span, std::array<bucket_limits, K> &buckets
         if (buckets[j].staged == buckets[j].end) {
             break;
         }
+    }
+
+    // The bits which were not used go back for the next phase
+    if constexpr (from_reservoir) {
+        gen.put_back(random_bits, bits_left);
+    }
+}
+
+// Rough Scatter with software prefetching for inputs beyond the last level cache. The items are 
+// moved as in cycle_rough_scatter, but the bucket indices are decoded W items ahead into a ring. 
+// When an index enters the ring we already know the slot its item will be dropped into: the 
+// staged position of its bucket plus the items in the ring before it which go to the same bucket. 
+// This slot is prefetched, so the random accesses of the next W items are in flight while we move 
+// the current one. The ring holds at most 64 bits, so the indices which were decoded but not used 
+// go back into a bit_reservoir together with the other bits which are left. The items, buckets 
+// and bits used are the same as with cycle_rough_scatter.
+template<std::size_t K, typename T, typename RNG, typename Index>
+void prefetching_rough_scatter(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
+    static_assert(std::has_single_bit(K), "The number of buckets has to be a power of two");
+    constexpr std::size_t LOG_K = std::bit_width(K) - 1;
+    constexpr std::size_t W = std::min(PREFETCH_DISTANCE, 64 / std::max<std::size_t>(LOG_K, 1));
+
+    // counter which shows how many bits are left
+    std::size_t bits_left = 0;
+    // bits will hold 
+    std::uint64_t random_bits = 0;
+    constexpr bool from_reservoir = requires { gen.take_available(); };
+    if constexpr (from_reservoir) {
+        std::tie(random_bits, bits_left) = gen.take_available();
+    }
+
+    // Prefetches past the end of data_span are clamped to its last item
+    const std::size_t last = data_span.size() - 1;
+    // ahead[j] is the number of items in the ring which go to bucket j
+    std::array<Index, K> ahead {};
+    auto decode = [&]() {
+        std::uint64_t j = next_bucket_index<LOG_K>(random_bits, bits_left, gen);
+        __builtin_prefetch(data_span.data() + std::min<std::size_t>(buckets[j].staged + ahead[j], last), 1);
+        ahead[j]++;
+        return j;
+    };
+    std::array<std::uint64_t, W> ring;
+    for (std::size_t k = 0; k < W; k++) {
+        ring[k] = decode();
+    }
+    std::size_t next = 0;
+
+    // The staged slot of bucket 0 is a hole while we hold its item
+    T hold = std::move(data_span[buckets[0].staged]);
+    while (true) {
+        // The item of j is still in the ring while the next index is decoded
+        std::uint64_t j = ring[next];
+        ring[next] = decode();
+        ahead[j]--;
+        next = next + 1 == W ? 0 : next + 1;
+
+        if (j == 0) {
+            data_span[buckets[0].staged] = std::move(hold);
+            buckets[0].staged++;
+            if (buckets[0].staged == buckets[0].end) {
+                break;
+            }
+            hold = std::move(data_span[buckets[0].staged]);
+        } else {
+            using std::swap;
+            swap(hold, data_span[buckets[j].staged]);
+            buckets[j].staged++;
+            if (buckets[j].staged == buckets[j].end) {
+                data_span[buckets[0].staged] = std::move(hold);
+                break;
+            }
+        }
+    }
 
-        // We check if we have to generate new random bits
-        if (bits_left < LOG_NUM_BUCKETS) {
-            random_bits = gen();
-            bits_left = 64;
+    // The indices in the ring come first in the stream, the oldest one in the lowest bits, then 
+    // the bits which are left. More than 64 bits were not all in the reservoir before, so the 
+    // reservoir has handed out a word we can put the upper 64 bits into.
+    if constexpr (from_reservoir) {
+        __uint128_t pending = random_bits;
+        for (std::size_t k = W; k > 0; k--) {
+            pending = (pending << LOG_K) | ring[(next + k - 1) % W];
+        }
+        const std::size_t n = W * LOG_K + bits_left;
+        if (n > 64) {
+            gen.put_back_word(static_cast<std::uint64_t>(pending >> (n - 64)));
+            gen.put_back(static_cast<std::uint64_t>(pending), n - 64);
+        } else {
+            gen.put_back(static_cast<std::uint64_t>(pending), n);
         }
     }
 }
 
-// Fine Scatter
-template<std::size_t K, typename T, typename RNG>
-void fine_scatter(std::span<T> data_span, std::array<bucket_limits, K> &buckets, RNG &gen) {
+// Rough Scatter which moves blocks of B items instead of single items, similar to the block 
+// permutation of IPS4o. The items are read from bucket 0 one after the other and wait in a buffer 
+// of their bucket. A full buffer is written to the staged slots of its bucket at once, and the B 
+// items which were there are put right before the next item to read. [buckets[0].staged, read) 
+// are the slots of bucket 0 which were read but not written yet, there are always as many as 
+// items in the buffers. Once a bucket is full, the buffers are written out the same way. This 
+// gives the layout of rough_scatter with one random cache line per B items instead of per item.
+// Michael Axtmann, Sascha Witt, Daniel Ferizovic, and Peter Sanders. 2017. In-Place Parallel Super Scalar Samplesort (IPSSSSo). ESA 2017. https://doi.org/10.4230/LIPIcs.ESA.2017.9
+template<std::size_t K, typename T, typename RNG, std::size_t B = SCATTER_BLOCK_SIZE, typename Index>
+    requires std::default_initializable<T>
+void block_rough_scatter(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
+    static_assert(std::has_single_bit(K), "The number of buckets has to be a power of two");
+    constexpr std::size_t LOG_K = std::bit_width(K) - 1;
+
+    // counter which shows how many bits are left
+    std::size_t bits_left = 0;
+    // bits will hold 
+    std::uint64_t random_bits = 0;
+    constexpr bool from_reservoir = requires { gen.take_available(); };
+    if constexpr (from_reservoir) {
+        std::tie(random_bits, bits_left) = gen.take_available();
+    }
+
+    std::array<std::array<T, B>, K> blocks;
+    std::array<std::size_t, K> counts {};
+    // The buffer of bucket j is written once it holds limits[j] items, this is less than B if the 
+    // bucket is full with them. One comparison per item covers both cases.
+    std::array<std::size_t, K> limits;
+    for (std::size_t j = 0; j < K; j++) {
+        limits[j] = std::min<std::size_t>(B, buckets[j].end - buckets[j].staged);
+    }
+    Index read = buckets[0].staged;
+    const Index read_end = buckets[0].end;
+
+    // Writes the items in the buffer of bucket j to its staged slots
+    auto write_block = [&](std::size_t j) {
+        const std::size_t count = counts[j];
+        const Index staged = buckets[j].staged;
+        if (j == 0) {
+            std::move(blocks[0].begin(), blocks[0].begin() + count, data_span.begin() + staged);
+        } else {
+            // The items which were not read yet are read next
+            read -= count;
+            for (std::size_t k = 0; k < count; k++) {
+                data_span[read + k] = std::move(data_span[staged + k]);
+                data_span[staged + k] = std::move(blocks[j][k]);
+            }
+        }
+        buckets[j].staged += count;
+        counts[j] = 0;
+        limits[j] = std::min<std::size_t>(B, buckets[j].end - buckets[j].staged);
+    };
+
+    while (true) {
+        // If bucket 0 has no items left to read, another bucket has to give us its items. Bucket 0 
+        // would be full if all the other buffers were empty.
+        if (read == read_end) {
+            std::size_t j = 1;
+            while (counts[j] == 0) {
+                j++;
+            }
+            write_block(j);
+        }
+        // We generate a new random index from random_bits
+        std::uint64_t j = next_bucket_index<LOG_K>(random_bits, bits_left, gen);
+
+        blocks[j][counts[j]] = std::move(data_span[read]);
+        read++;
+        counts[j]++;
+
+        if (counts[j] == limits[j]) {
+            if (buckets[j].staged + counts[j] == buckets[j].end) {
+                break;
+            }
+            write_block(j);
+        }
+    }
+
+    // Bucket 0 last, then its remaining slots are exactly the ones for its buffer
+    for (std::size_t j = 1; j < K; j++) {
+        write_block(j);
+    }
+    write_block(0);
+
+    // The bits which were not used go back for the next phase
+    if constexpr (from_reservoir) {
+        gen.put_back(random_bits, bits_left);
+    }
+}
+
+// Rough Scatter which follows the cycles of the permutation instead of swapping through bucket 0. 
+// The item at the staged slot of bucket 0 is held in a register, dropped into the staged slot of 
+// its bucket, and the item which was there is the next one we hold. Only items for bucket 0 go 
+// back to bucket 0. This gives the same items and buckets as rough_scatter, but each item is read 
+// and written once and the loads do not wait for the store to the staged slot of bucket 0.
+template<std::size_t K, typename T, typename RNG, typename Index>
+void cycle_rough_scatter(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
+    static_assert(std::has_single_bit(K), "The number of buckets has to be a power of two");
+    constexpr std::size_t LOG_K = std::bit_width(K) - 1;
+
+    // counter which shows how many bits are left
+    std::size_t bits_left = 0;
+    // bits will hold 
+    std::uint64_t random_bits = 0;
+    constexpr bool from_reservoir = requires { gen.take_available(); };
+    if constexpr (from_reservoir) {
+        std::tie(random_bits, bits_left) = gen.take_available();
+    }
+
+    // The staged slot of bucket 0 is a hole while we hold its item
+    T hold = std::move(data_span[buckets[0].staged]);
+    while (true) {
+        // We generate a new random index from random_bits
+        std::uint64_t j = next_bucket_index<LOG_K>(random_bits, bits_left, gen);
+
+        if (j == 0) {
+            data_span[buckets[0].staged] = std::move(hold);
+            buckets[0].staged++;
+            if (buckets[0].staged == buckets[0].end) {
+                break;
+            }
+            hold = std::move(data_span[buckets[0].staged]);
+        } else {
+            using std::swap;
+            swap(hold, data_span[buckets[j].staged]);
+            buckets[j].staged++;
+            if (buckets[j].staged == buckets[j].end) {
+                data_span[buckets[0].staged] = std::move(hold);
+                break;
+            }
+        }
+    }
+
+    // The bits which were not used go back for the next phase
+    if constexpr (from_reservoir) {
+        gen.put_back(random_bits, bits_left);
+    }
+}
+
+// A uniform double from [0, 1) made of the upper 53 bits of one word of gen. A bit_reservoir 
+// hands out exactly 53 bits.
+template<typename RNG>
+double uniform_double_53(RNG &gen) {
+    if constexpr (requires { gen.bits(53); }) {
+        return static_cast<double>(gen.bits(53)) * 0x1.0p-53;
+    } else {
+        return static_cast<double>(random_word_64(gen) >> 11) * 0x1.0p-53;
+    }
+}
+
+// log(k!) - [(k + 0.5) log(k + 1) - (k + 1) + 0.5 log(2 pi)], the error of Stirling's 
+// approximation. Exact values for small k and the asymptotic series otherwise.
+inline double stirling_approx_tail(double k) {
+    static constexpr std::array<double, 10> small_k = {
+        0.08106146679532726, 0.04134069595540929, 0.02767792568499834, 0.02079067210376509, 
+        0.01664469118982119, 0.01387612882307075, 0.01189670994589177, 0.01041126526197209, 
+        0.009255462182712733, 0.008330563433362871
+    };
+    if (k <= 9) {
+        return small_k[static_cast<std::size_t>(k)];
+    }
+    double kp1sq = (k + 1) * (k + 1);
+    return (1.0 / 12 - (1.0 / 360 - 1.0 / 1260 / kp1sq) / kp1sq) / (k + 1);
+}
+
+// Binomial sampling by inversion, for n * p < 10. Expected time O(n * p).
+template<typename RNG>
+std::size_t binomial_inversion(std::size_t n, double p, RNG &gen) {
+    const double q = 1 - p;
+    const double s = p / q;
+    const double a = (static_cast<double>(n) + 1) * s;
+    const double r0 = std::exp(static_cast<double>(n) * std::log1p(-p));
+    while (true) {
+        double r = r0;
+        double u = uniform_double_53(gen);
+        std::size_t x = 0;
+        while (u > r) {
+            u -= r;
+            x++;
+            r *= a / static_cast<double>(x) - s;
+            // Rounding errors can leave u slightly above the total mass, we simply start over
+            if (x > n || r <= 0) {
+                break;
+            }
+        }
+        if (x <= n && u <= r) {
+            return x;
+        }
+    }
+}
+
+// Binomial sampling with BTRS (transformed rejection with squeeze), for n * p >= 10 and p <= 0.5. 
+// Expected time O(1).
+// Wolfgang Hörmann. 1993. The generation of binomial random variates. Journal of Statistical Computation and Simulation 46, 1-2, 101-110. https://doi.org/10.1080/00949659308811496
+template<typename RNG>
+std::size_t binomial_btrs(std::size_t n, double p, RNG &gen) {
+    const double count = static_cast<double>(n);
+    const double stddev = std::sqrt(count * p * (1 - p));
+    const double b = 1.15 + 2.53 * stddev;
+    const double a = -0.0873 + 0.0248 * b + 0.01 * p;
+    const double c = count * p + 0.5;
+    const double v_r = 0.92 - 4.2 / b;
+    const double r = p / (1 - p);
+    const double alpha = (2.83 + 5.1 / b) * stddev;
+    const double m = std::floor((count + 1) * p);
+
+    while (true) {
+        double u = uniform_double_53(gen) - 0.5;
+        double v = uniform_double_53(gen);
+        double us = 0.5 - std::abs(u);
+        double k = std::floor((2 * a / us + b) * u + c);
+        if (k < 0 || k > count) {
+            continue;
+        }
+        // Squeeze, most samples are accepted here
+        if (us >= 0.07 && v <= v_r) {
+            return static_cast<std::size_t>(k);
+        }
+
+        v = std::log(v * alpha / (a / (us * us) + b));
+        double upper_bound = (m + 0.5) * std::log((m + 1) / (r * (count - m + 1)))
+                           + (count + 1) * std::log((count - m + 1) / (count - k + 1))
+                           + (k + 0.5) * std::log(r * (count - k + 1) / (k + 1))
+                           + stirling_approx_tail(m) + stirling_approx_tail(count - m)
+                           - stirling_approx_tail(k) - stirling_approx_tail(count - k);
+        if (v <= upper_bound) {
+            return static_cast<std::size_t>(k);
+        }
+    }
+}
+
+// Draws from Bin(n, p). Unlike std::binomial_distribution this needs no setup. The samples only 
+// depend on our own code and on std::exp, std::log and std::lgamma, hence they are the same with 
+// every standard library given identical libm results. These may differ in the last bit between 
+// libraries, which can change an acceptance decision of binomial_btrs.
+template<typename RNG>
+std::size_t binomial(std::size_t n, double p, RNG &gen) {
+    if (n == 0 || p <= 0) {
+        return 0;
+    }
+    if (p >= 1) {
+        return n;
+    }
+    if (p > 0.5) {
+        return n - binomial(n, 1 - p, gen);
+    }
+    if (static_cast<double>(n) * p < 10) {
+        return binomial_inversion(n, p, gen);
+    }
+    return binomial_btrs(n, p, gen);
+}
+
+// Splits n items uniformly at random into K parts, i.e. draws from the multinomial distribution 
+// with K equally likely outcomes. Part i gets Bin(remaining, 1 / (K - i)) items. A bit_reservoir 
+// assigns few items one by one instead, with log2(K) bits each, which is cheaper than K - 1 
+// binomials of at least 53 bits each and gives the same distribution.
+template<std::size_t K, typename RNG>
+std::array<std::size_t, K> multinomial(std::size_t n, RNG &gen) {
+    std::array<std::size_t, K> parts {};
+    if constexpr (K > 1 && std::has_single_bit(K) && requires { gen.bits(53); }) {
+        constexpr std::size_t LOG_K = std::bit_width(K) - 1;
+        if (n * LOG_K < (K - 1) * 53) {
+            for (; n > 0; n--) {
+                parts[gen.bits(LOG_K)]++;
+            }
+            return parts;
+        }
+    }
+    for (std::size_t i = 0; i+1 < K; i++) {
+        parts[i] = binomial(n, 1.0/static_cast<double>(K - i), gen);
+        n -= parts[i];
+    }
+    parts[K-1] = n;
+    return parts;
+}
+
+// Draws the final size of every bucket: its placed items plus its share of the staged items.
+template<std::size_t K, typename RNG, typename Index>
+std::array<size_t, K> draw_final_bucket_sizes(std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
     std::array<size_t, K> num_of_placed_items {};
     std::array<size_t, K> num_to_be_placed_items {};
     std::array<size_t, K> final_bucket_sizes {};
@@ -357,21 +1066,21 @@ void fine_scatter(std::span<T> data_span, std::array<bucket_limits, K> &buckets,
         num_staged_items += bucket.num_staged();
     }
     
-    // This line might be unnecessary 
-    std::size_t ns = num_staged_items;
-    for (std::size_t i = 0; i+1 < K; i++) {
-        auto binom = std::binomial_distribution{ns, 1.0/static_cast<double>(K - i)};
-        auto x = binom(gen);
-        num_to_be_placed_items[i] = x;
-        ns -= x;
-    }
-    num_to_be_placed_items[K-1] = ns;
+    num_to_be_placed_items = multinomial<K>(num_staged_items, gen);
 
     // Calculate the sum of both vectors and store it in n_f
     // Here I could use the std::transform function
     for (std::size_t i = 0; i < K; i++) {
         final_bucket_sizes[i] = num_of_placed_items[i] + num_to_be_placed_items[i];
     }
+    return final_bucket_sizes;
+}
+
+// First part of Fine Scatter: draws the final bucket sizes and moves the bucket boundaries there. 
+// The staged items stay where they are.
+template<std::size_t K, typename T, typename RNG, typename Index>
+void rebalance_buckets(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
+    std::array<size_t, K> final_bucket_sizes = draw_final_bucket_sizes(buckets, gen);
 
     // We sweep from left to right. Similar to Penschuck's code. We don't precalcute the C values.
     // Penschuck's code https://github.com/manpen/rip_shuffle?tab=readme-ov-file
@@ -403,46 +1112,1455 @@ void fine_scatter(std::span<T> data_span, std::array<bucket_limits, K> &buckets,
             buckets[i-1].end++;
         }
     }
+}
+
+// Fine Scatter
+template<std::size_t K, typename T, typename RNG, typename Index>
+void fine_scatter(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
+    rebalance_buckets(data_span, buckets, gen);
 
     // Now we shuffle the stashes
     shuffle_stashes(data_span, buckets, gen);
 }
 
-// Our InplaceScatterShuffle implementation
-template<typename T, typename RNG>
-void inplace_scatter_shuffle(std::span<T> data_span, RNG &gen) {
-    // Might be unnecessary
-    if (data_span.empty()) {
-        return;
+// Splits n items into K buckets of (nearly) equal size. Nothing is placed yet.
+template<std::size_t K, typename Index>
+void init_buckets(std::size_t n, std::array<basic_bucket_limits<Index>, K> &buckets) {
+    for (std::size_t i = 0; i < K; i++) {
+        buckets[i].begin = static_cast<Index>(n * i / K);
+        buckets[i].staged = static_cast<Index>(n * i / K);
+        buckets[i].end = static_cast<Index>(n * (i+1) / K);
     }
+}
 
-    if (data_span.size() <= THRESHOLD) {
-        buffered_fisher_yates_shuffle(data_span, gen);
-        return;
-    }
+// A generator which hands out the words of gen from a block of N words. The block is refilled in 
+// one tight loop without any other dependencies, so the generator can pipeline instead of sitting 
+// on the critical path of the swap loop of rough_scatter. It can be used in place of gen 
+// everywhere. Words which are still in the block when the buffer is destroyed are lost.
+// The parallel scatter shuffle wraps only its rough scatters in it, the other phases draw from gen 
+// directly.
+template<typename RNG, std::size_t N = 256>
+class random_word_buffer {
+public:
+    using result_type = typename RNG::result_type;
 
-    // Maybe I should creade a small fucntion which creates the buckets to make this function 
-    // a bit cleaner.
-    std::array<bucket_limits, NUM_BUCKETS> buckets;
-    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
-        buckets[i].begin = static_cast<std::size_t>(data_span.size()) * i / NUM_BUCKETS;
-        buckets[i].staged = static_cast<std::size_t>(data_span.size()) * i / NUM_BUCKETS;;
-        buckets[i].end = static_cast<std::size_t>(data_span.size()) * (i+1) / NUM_BUCKETS;
+    explicit random_word_buffer(RNG &gen) : gen(gen) {}
+
+    static constexpr result_type min() { return RNG::min(); }
+    static constexpr result_type max() { return RNG::max(); }
+
+    result_type operator()() {
+        if (index == N) {
+            refill();
+        }
+        return words[index++];
+    }
+
+private:
+    void refill() {
+        // Generators with a block API, e.g. xoshiro256pp_simd, write the whole block at once
+        if constexpr (requires { gen.fill(words.data(), N); }) {
+            gen.fill(words.data(), N);
+        } else {
+            for (auto &word : words) {
+                word = gen();
+            }
+        }
+        index = 0;
     }
 
-    // Rough Scatter
-    rough_scatter(data_span, buckets, gen);
+    RNG &gen;
+    std::array<result_type, N> words;
+    std::size_t index = N;
+};
+
+// A continuous stream of the random bits of gen. bits(n) hands out the next n bits and the bits of 
+// a word which are not needed yet stay in the reservoir for the next call. rough_scatter hands 
+// the bits it did not use back, so they are used by the next phase or the next level of the 
+// recursion instead of being dropped, and the doubles of the binomial samplers take 53 bits 
+// instead of a word. As a generator it hands out whole words, which does not touch the bits in 
+// the reservoir. The words are drawn from a block of N words as in random_word_buffer.
+template<std::uniform_random_bit_generator RNG, std::size_t N = 256>
+class bit_reservoir {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit bit_reservoir(RNG &gen) : gen(gen) {}
+
+    // The next n bits, 0 < n <= 64
+    std::uint64_t bits(std::size_t n) {
+        const std::uint64_t mask = ~std::uint64_t(0) >> (64 - n);
+        if (n <= available) {
+            std::uint64_t x = reservoir & mask;
+            // Two shifts, since a shift by 64 is undefined
+            reservoir = reservoir >> (n - 1) >> 1;
+            available -= n;
+            return x;
+        }
+        // The available bits are the low bits of the result, the rest comes from the next word
+        std::uint64_t word = next_word();
+        std::uint64_t x = (reservoir | (word << available)) & mask;
+        std::size_t taken = n - available;
+        reservoir = word >> (taken - 1) >> 1;
+        available = 64 - taken;
+        return x;
+    }
+
+    // The next whole word, the bits in the reservoir stay for the next call of bits
+    result_type operator()() { return next_word(); }
+
+    // Takes all available bits out of the reservoir, as the value and the number of bits. Hot 
+    // loops keep them in registers and hand the rest back with put_back.
+    std::pair<std::uint64_t, std::size_t> take_available() {
+        std::pair<std::uint64_t, std::size_t> taken {reservoir, available};
+        reservoir = 0;
+        available = 0;
+        return taken;
+    }
+
+    // Puts the low n bits of x back, they are the next bits of the stream. The reservoir has to be 
+    // empty.
+    void put_back(std::uint64_t x, std::size_t n) {
+        reservoir = n == 0 ? 0 : x & (~std::uint64_t(0) >> (64 - n));
+        available = n;
+    }
+
+    // Puts x back as the next whole word, in front of the words which were not handed out yet. The 
+    // reservoir has to have handed out a word which was not put back yet. Together with put_back 
+    // this returns up to 128 bits.
+    void put_back_word(std::uint64_t x) {
+        index--;
+        words[index] = x;
+    }
+
+    // Number of random bits handed out so far. Divided by the number of items this is the cost of a 
+    // shuffle in random bits per item, which is at least log2(n!) / n.
+    std::uint64_t bits_consumed() const {
+        std::uint64_t words_drawn = N * refills - (N - index);
+        return 64 * words_drawn - available;
+    }
+
+private:
+    std::uint64_t next_word() {
+        if (index == N) {
+            // Generators with a block API, e.g. xoshiro256pp_simd, write the whole block at once
+            if constexpr (random_generator_64<RNG> && requires { gen.fill(words.data(), N); }) {
+                gen.fill(words.data(), N);
+            } else {
+                for (auto &word : words) {
+                    word = random_word_64(gen);
+                }
+            }
+            index = 0;
+            refills++;
+        }
+        return words[index++];
+    }
+
+    RNG &gen;
+    std::array<std::uint64_t, N> words;
+    std::size_t index = N;
+    // The low available bits of reservoir are the next bits of the stream, the others are 0
+    std::uint64_t reservoir = 0;
+    std::size_t available = 0;
+    std::uint64_t refills = 0;
+};
+
+// Parses a cache size like "48K" or "2M" as found in /sys/devices/system/cpu. Returns 0 if it is 
+// not a size.
+inline std::size_t parse_cache_size(const std::string &size) {
+    std::size_t pos = 0;
+    std::size_t bytes = 0;
+    try {
+        bytes = std::stoull(size, &pos);
+    } catch (const std::exception&) {
+        return 0;
+    }
+    if (pos < size.size()) {
+        switch (size[pos]) {
+            case 'K': bytes <<= 10; break;
+            case 'M': bytes <<= 20; break;
+            case 'G': bytes <<= 30; break;
+            default: break;
+        }
+    }
+    return bytes;
+}
+
+// Sizes in bytes of the data caches of one core, 0 stands for a cache which does not exist or 
+// is unknown. By default inplace_scatter_shuffle adapts the levels to detected_cache_sizes(), then 
+// the permutation for a seed depends on the machine. With unknown caches every level uses 
+// NUM_BUCKETS and the permutation only depends on the generator.
+struct cache_sizes {
+    std::size_t l1 = 0;
+    std::size_t l2 = 0;
+    std::size_t l3 = 0;
+
+    // Reads the caches of cpu 0 from /sys/devices/system/cpu. Returns unknown caches if they are 
+    // not available, e.g. on other operating systems or inside some containers.
+    static cache_sizes detect() {
+        cache_sizes caches;
+        for (std::size_t index = 0; ; index++) {
+            const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+            std::ifstream level_file(dir + "level");
+            std::ifstream type_file(dir + "type");
+            std::ifstream size_file(dir + "size");
+            std::size_t level = 0;
+            std::string type;
+            std::string size;
+            if (!(level_file >> level) || !(type_file >> type) || !(size_file >> size)) {
+                break;
+            }
+            if (type == "Instruction") {
+                continue;
+            }
+            switch (level) {
+                case 1: caches.l1 = parse_cache_size(size); break;
+                case 2: caches.l2 = parse_cache_size(size); break;
+                case 3: caches.l3 = parse_cache_size(size); break;
+                default: break;
+            }
+        }
+        return caches;
+    }
+};
+
+// The caches of this machine, read once
+inline const cache_sizes &detected_cache_sizes() {
+    static const cache_sizes caches = cache_sizes::detect();
+    return caches;
+}
+
+// The size of the last cache, 0 if it is unknown
+inline std::size_t last_cache_size(const cache_sizes &caches) {
+    return caches.l3 != 0 ? caches.l3 : caches.l2;
+}
+
+// The number of buckets (as logarithm) of a level with the given number of bytes. Levels which 
+// do not fit into the last cache are bound by memory and get NUM_BUCKETS, which was the best 
+// number of buckets for these sizes in our measurements. Smaller levels get the fewest buckets 
+// whose subproblems fit into L2, the next level or Fisher-Yates then works in L2. The staged slots 
+// of all buckets, one cache line each, have to fit into half of L1.
+inline std::size_t choose_log_num_buckets(std::size_t bytes, const cache_sizes &caches) {
+    const std::size_t last_cache = last_cache_size(caches);
+    if (caches.l2 == 0 || bytes > last_cache) {
+        return LOG_NUM_BUCKETS;
+    }
+    std::size_t log_k = LOG_MIN_NUM_BUCKETS;
+    while (log_k < LOG_MAX_NUM_BUCKETS && (bytes >> log_k) > caches.l2) {
+        log_k++;
+    }
+    while (log_k > LOG_MIN_NUM_BUCKETS && caches.l1 != 0 && (std::size_t(64) << log_k) > caches.l1 / 2) {
+        log_k--;
+    }
+    return log_k;
+}
+
+// The rough scatter of the levels which do not fit into the last cache. ROUGH_SCATTER_KERNEL 0 is 
+// cycle_rough_scatter. 1 is prefetching_rough_scatter, which gives the same items, buckets and bits. 
+// 2 is block_rough_scatter, which puts the items of a bucket in another order, for items which are 
+// default-initializable. On our machines the hardware prefetcher follows the staged positions and 
+// cycle_rough_scatter is the fastest, hence it is the default.
+template<std::size_t K, typename T, typename RNG, typename Index>
+void large_rough_scatter(std::span<T> data_span, std::array<basic_bucket_limits<Index>, K> &buckets, RNG &gen) {
+    if constexpr (ROUGH_SCATTER_KERNEL == 1) {
+        prefetching_rough_scatter(data_span, buckets, gen);
+    } else if constexpr (ROUGH_SCATTER_KERNEL == 2 && std::default_initializable<T>) {
+        block_rough_scatter(data_span, buckets, gen);
+    } else {
+        cycle_rough_scatter(data_span, buckets, gen);
+    }
+}
+
+template<typename T, typename RNG, std::size_t N>
+void inplace_scatter_shuffle(std::span<T> data_span, bit_reservoir<RNG, N> &bits, const cache_sizes &caches);
+
+// One level of inplace_scatter_shuffle with 2^LOG_K buckets whose positions are of type Index
+template<std::size_t LOG_K, typename Index, typename T, typename RNG, std::size_t N>
+void scatter_shuffle_level(std::span<T> data_span, bit_reservoir<RNG, N> &bits, const cache_sizes &caches) {
+    constexpr std::size_t K = std::size_t(1) << LOG_K;
+    static_assert(K <= THRESHOLD, "Every bucket needs at least one item");
+
+    std::array<basic_bucket_limits<Index>, K> buckets;
+    init_buckets(data_span.size(), buckets);
+
+    // Rough Scatter. Levels which do not fit into the last cache use the kernel selected by 
+    // ROUGH_SCATTER_KERNEL, see large_rough_scatter.
+    const std::size_t last_cache = last_cache_size(caches);
+    if (last_cache != 0 && data_span.size_bytes() > last_cache) {
+        large_rough_scatter(data_span, buckets, bits);
+    } else {
+        cycle_rough_scatter(data_span, buckets, bits);
+    }
 
     // Fine Scatter which does the twosweap thing and assigns the last itmes 
-    fine_scatter(data_span, buckets, gen);
+    fine_scatter(data_span, buckets, bits);
 
     // Squentially calling inplace_scatter_schuffle on each bucket.
     // This part should be hhighly parallelisable.
-    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+    for (std::size_t i = 0; i < K; i++) {
         // Might be unnecessary to create a span
         std::span bucket_span = data_span.subspan(buckets[i].begin, buckets[i].num_total());
-        inplace_scatter_shuffle(bucket_span, gen);
+        inplace_scatter_shuffle(bucket_span, bits, caches);
+    }
+}
+
+// Calls scatter_shuffle_level<log_k, Index>, it is compiled for all log_k from LOG_MIN_NUM_BUCKETS 
+// to LOG_MAX_NUM_BUCKETS and NUM_BUCKETS
+template<typename Index, std::size_t LOG_K = std::min(LOG_MIN_NUM_BUCKETS, LOG_NUM_BUCKETS), typename T, typename RNG, std::size_t N>
+void scatter_shuffle_level(std::size_t log_k, std::span<T> data_span, bit_reservoir<RNG, N> &bits, const cache_sizes &caches) {
+    if constexpr (LOG_K < std::max(LOG_MAX_NUM_BUCKETS, LOG_NUM_BUCKETS)) {
+        if (log_k > LOG_K) {
+            scatter_shuffle_level<Index, LOG_K + 1>(log_k, data_span, bits, caches);
+            return;
+        }
+    }
+    scatter_shuffle_level<LOG_K, Index>(data_span, bits, caches);
+}
+
+// Our InplaceScatterShuffle implementation. All levels of the recursion draw their random bits 
+// from the same bit_reservoir. The number of buckets of every level is chosen for its size and 
+// caches, see choose_log_num_buckets.
+template<typename T, typename RNG, std::size_t N>
+void inplace_scatter_shuffle(std::span<T> data_span, bit_reservoir<RNG, N> &bits, const cache_sizes &caches) {
+    // Might be unnecessary
+    if (data_span.empty()) {
+        return;
+    }
+
+    if (data_span.size() <= THRESHOLD) {
+        buffered_fisher_yates_shuffle(data_span, bits);
+        return;
+    }
+
+    const std::size_t log_k = choose_log_num_buckets(data_span.size_bytes(), caches);
+    // 32-bit positions once the subproblem is small enough
+    if (data_span.size() <= std::numeric_limits<std::uint32_t>::max()) {
+        scatter_shuffle_level<std::uint32_t>(log_k, data_span, bits, caches);
+    } else {
+        scatter_shuffle_level<std::size_t>(log_k, data_span, bits, caches);
+    }
+}
+
+// Same as above with the caches of this machine
+template<typename T, typename RNG, std::size_t N>
+void inplace_scatter_shuffle(std::span<T> data_span, bit_reservoir<RNG, N> &bits) {
+    inplace_scatter_shuffle(data_span, bits, detected_cache_sizes());
+}
+
+template<typename T, typename RNG>
+void inplace_scatter_shuffle(std::span<T> data_span, RNG &gen, const cache_sizes &caches) {
+    if (data_span.size() <= THRESHOLD) {
+        buffered_fisher_yates_shuffle(data_span, gen);
+        return;
     }
+    bit_reservoir<RNG> bits(gen);
+    inplace_scatter_shuffle(data_span, bits, caches);
 }
 
+// Levels adapted to the caches of this machine. Usage with the same permutation for a seed on 
+// every machine: inplace_scatter_shuffle(data_span, gen, cache_sizes {})
+template<typename T, typename RNG>
+void inplace_scatter_shuffle(std::span<T> data_span, RNG &gen) {
+    inplace_scatter_shuffle(data_span, gen, detected_cache_sizes());
+}
+
+// Merges the shuffled blocks [0, mid) and [mid, n) of data_span into one shuffled block. Every 
+// step takes the next item from the left or the right block depending on one random bit. Once one 
+// block runs out, the remaining items are inserted at random positions as in Fisher-Yates.
+// Axel Bacher, Olivier Bodini, Alexandros Hollender, and Jérémie Lumbroso. 2015. MergeShuffle: A Very Fast, Parallel Random Permutation Algorithm. https://arxiv.org/abs/1508.03167
+template<typename T, typename RNG>
+void merge_shuffled_blocks(std::span<T> data_span, std::size_t mid, RNG &gen) {
+    const std::size_t n = data_span.size();
+    std::size_t i = 0;
+    std::size_t j = mid;
+
+    std::uint64_t random_bits = 0;
+    std::size_t bits_left = 0;
+    using std::swap;
+    while (true) {
+        if (bits_left == 0) {
+            random_bits = random_word(gen);
+            bits_left = random_word_bits<RNG>;
+        }
+        bool take_right = random_bits & 1;
+        random_bits >>= 1;
+        bits_left--;
+
+        if (take_right) {
+            if (j == n) {
+                break;
+            }
+            swap(data_span[i], data_span[j]);
+            j++;
+        } else if (i == j) {
+            break;
+        }
+        i++;
+    }
+
+    for (; i < n; i++) {
+        // uniform sample from [0, i]
+        std::size_t k = my_uniform_int_distribution_64(i + 1, gen);
+        swap(data_span[i], data_span[k]);
+    }
+}
+
+// MergeShuffle: both halves are shuffled recursively and merged with merge_shuffled_blocks. Blocks 
+// with at most THRESHOLD items are shuffled with Fisher-Yates as in inplace_scatter_shuffle.
+template<typename T, typename RNG>
+void merge_shuffle(std::span<T> data_span, RNG &gen) {
+    if (data_span.size() <= THRESHOLD) {
+        buffered_fisher_yates_shuffle(data_span, gen);
+        return;
+    }
+
+    const std::size_t mid = data_span.size() / 2;
+    merge_shuffle(data_span.first(mid), gen);
+    merge_shuffle(data_span.subspan(mid), gen);
+    merge_shuffled_blocks(data_span, mid, gen);
+}
+
+// Derives the seed of the child with the given index from the seed of its parent. This is the 
+// mixing function of SplitMix64, so neighbouring indices and levels give unrelated seeds.
+// Guy L. Steele, Doug Lea, and Christine H. Flood. 2014. Fast Splittable Pseudorandom Number Generators. OOPSLA '14. https://doi.org/10.1145/2660193.2660195
+inline std::uint64_t derive_seed(std::uint64_t seed, std::uint64_t index) {
+    std::uint64_t z = seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// derive_seed for wider integers, e.g. the 128-bit streams and distances of pcg64. Every 64-bit 
+// limb is mixed together with the limbs below it.
+template<typename UInt>
+UInt derive_value(UInt value, std::uint64_t index) {
+    UInt result = 0;
+    std::uint64_t h = 0;
+    for (std::size_t shift = 0; shift < sizeof(UInt) * 8; shift += 64) {
+        h = derive_seed(static_cast<std::uint64_t>(value >> shift) ^ h, index);
+        result |= static_cast<UInt>(h) << shift;
+    }
+    return result;
+}
+
+// Generators with selectable streams which can be constructed from a state and a stream (pcg 
+// engines with set_stream, philox4x64) and generators with a fast jump-ahead (every pcg engine, 
+// e.g. pcg64_fast)
+template<typename RNG>
+concept stream_selectable_generator = requires (RNG g) { 
+    requires RNG::can_specify_stream; 
+    RNG(g.stream(), g.stream()); 
+};
+
+template<typename RNG>
+concept advanceable_generator = requires (RNG g) { g.advance(1); };
+
+// Generators whose security depends on the full key, e.g. chacha. A child of split_generator or 
+// seeded_generator only has the entropy of at most two 64-bit words, hence these refuse them.
+template<typename RNG>
+concept cryptographic_generator = requires { requires RNG::is_cryptographic; };
+
+// Returns the child with the given index of gen without changing gen. The children of a generator 
+// are independent of each other, of gen and of the children of other generators, so a shuffle can 
+// split its generator per bucket at every level of the recursion, and a single bucket can be 
+// replayed from the generator of its parent. Everything is derived from the index and the next 
+// word of gen, hence splitting gen again after using it gives new children. Depending on RNG we use
+// - stream selection: the child is constructed from a derived state and a derived stream, which 
+//   is O(1) for the pcg engines with set_stream and for philox4x64.
+// - jump-ahead: the child starts a derived distance of the full state width after gen. This is 
+//   O(log period) for pcg engines without streams, e.g. pcg64_fast.
+// - seeding: the child is seeded with two words of gen and the index through std::seed_seq.
+template<typename RNG>
+RNG split_generator(const RNG &gen, std::uint64_t index) {
+    static_assert(!cryptographic_generator<RNG>, "A child has at most 128 bits of entropy, use the sequential shuffles");
+    RNG child = gen;
+    const std::uint64_t position = random_word_64(child);
+    if constexpr (stream_selectable_generator<RNG>) {
+        auto key = child.stream() ^ position;
+        return RNG(derive_value(key, ~index), derive_value(key, index));
+    } else if constexpr (advanceable_generator<RNG>) {
+        child = gen;
+        child.advance(derive_value(static_cast<typename RNG::state_type>(position), index));
+        return child;
+    } else {
+        const std::uint64_t x = random_word_64(child);
+        std::seed_seq seed_sequence {
+            static_cast<std::uint32_t>(position), static_cast<std::uint32_t>(position >> 32),
+            static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(x >> 32),
+            static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32)
+        };
+        return RNG(seed_sequence);
+    }
+}
+
+// The children 0, ..., n - 1 of gen, see split_generator
+template<typename RNG>
+std::vector<RNG> split_generators(const RNG &gen, std::size_t n) {
+    std::vector<RNG> children;
+    children.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        children.push_back(split_generator(gen, i));
+    }
+    return children;
+}
+
+// Creates a generator which only depends on the given 64-bit seed. Tasks carry such a seed so that 
+// their result does not depend on the worker which executes them. Generators with streams get a 
+// derived state and stream as in split_generator, all others are seeded through std::seed_seq.
+template<typename RNG>
+RNG seeded_generator(std::uint64_t seed) {
+    static_assert(!cryptographic_generator<RNG>, "A 64-bit seed is not enough for a key, use the sequential shuffles");
+    if constexpr (stream_selectable_generator<RNG>) {
+        using stream_type = decltype(std::declval<RNG&>().stream());
+        return RNG(derive_value(static_cast<stream_type>(seed), 0), derive_value(static_cast<stream_type>(seed), 1));
+    } else {
+        std::seed_seq seed_sequence {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+        return RNG(seed_sequence);
+    }
+}
+
+// Runs f(0), ..., f(num_threads - 1) concurrently and waits for all of them. The calling 
+// thread executes f(0) itself.
+template<typename F>
+void fork_join(std::size_t num_threads, F &&f) {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (std::size_t t = 1; t < num_threads; t++) {
+        threads.emplace_back(f, t);
+    }
+    f(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+// Lock-free work-stealing deque of Chase and Lev. The owner pushes and pops at the bottom, all other 
+// threads steal from the top. The memory orderings follow 
+// Nhat Minh Lê, Antoniu Pop, Albert Cohen, and Francesco Zappa Nardelli. 2013. Correct and Efficient Work-Stealing for Weak Memory Models. PPoPP '13. https://doi.org/10.1145/2442516.2442524
+// Rings which were replaced by a larger one are kept alive until the deque is destroyed since a 
+// thief might still read from them.
+template<typename T>
+class chase_lev_deque {
+public:
+    explicit chase_lev_deque(std::int64_t capacity = 256) {
+        rings.push_back(std::make_unique<ring>(capacity));
+        array.store(rings.back().get(), std::memory_order_relaxed);
+    }
+
+    // Only the owner may call push and pop
+    void push(T *item) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        ring *a = array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            rings.push_back(a->grow(t, b));
+            a = rings.back().get();
+            array.store(a, std::memory_order_release);
+        }
+        a->put(b, item);
+        // Publishes the item to the thieves
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    T *pop() {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        ring *a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        T *item = nullptr;
+        if (t <= b) {
+            item = a->get(b);
+            if (t == b) {
+                // Last item, we race against the thieves
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    T *steal() {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+
+        T *item = nullptr;
+        if (t < b) {
+            ring *a = array.load(std::memory_order_acquire);
+            item = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+        }
+        return item;
+    }
+
+private:
+    struct ring {
+        std::int64_t capacity;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+
+        explicit ring(std::int64_t c) : capacity(c), slots(new std::atomic<T*>[c]) {}
+
+        T *get(std::int64_t i) { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, T *item) { slots[i & (capacity - 1)].store(item, std::memory_order_relaxed); }
+
+        std::unique_ptr<ring> grow(std::int64_t t, std::int64_t b) {
+            auto larger = std::make_unique<ring>(2 * capacity);
+            for (std::int64_t i = t; i < b; i++) {
+                larger->put(i, get(i));
+            }
+            return larger;
+        }
+    };
+
+    alignas(64) std::atomic<std::int64_t> top {0};
+    alignas(64) std::atomic<std::int64_t> bottom {0};
+    std::atomic<ring*> array;
+    std::vector<std::unique_ptr<ring>> rings;
+};
+
+// Parses a Linux cpu list like "0-3,8,10-11" as found in /sys/devices/system/node.
+inline std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        std::size_t comma = list.find(',', pos);
+        std::string range = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        std::size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // Trailing newline or garbage, nothing to add
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+// The memory nodes of the machine and the cpus which belong to them. Nodes are referred to by 
+// their index in node_ids, which need not be the id the kernel uses (node ids may have gaps). An 
+// empty topology stands for a machine without NUMA information; then nothing gets pinned.
+struct numa_topology {
+    std::vector<int> node_ids;
+    std::vector<std::vector<int>> node_cpus;
+
+    std::size_t num_nodes() const { return node_ids.size(); }
+
+    // Reads the topology from /sys/devices/system/node. Returns an empty topology if it is not 
+    // available, e.g. on other operating systems or inside some containers.
+    static numa_topology detect() {
+        numa_topology topology;
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string list;
+        if (!std::getline(online, list)) {
+            return topology;
+        }
+        for (int node : parse_cpu_list(list)) {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string cpus;
+            std::getline(cpulist, cpus);
+            std::vector<int> node_cpus = parse_cpu_list(cpus);
+            // Memory-only nodes cannot run workers
+            if (!node_cpus.empty()) {
+                topology.node_ids.push_back(node);
+                topology.node_cpus.push_back(std::move(node_cpus));
+            }
+        }
+        return topology;
+    }
+
+    // Index of the node with the given cpu or -1
+    int node_of_cpu(int cpu) const {
+        for (std::size_t n = 0; n < num_nodes(); n++) {
+            if (std::find(node_cpus[n].begin(), node_cpus[n].end(), cpu) != node_cpus[n].end()) {
+                return static_cast<int>(n);
+            }
+        }
+        return -1;
+    }
+
+    // Index of the node which holds most of the sampled pages of [data, data + bytes) or -1 if 
+    // this is unknown, e.g. because the pages are not faulted in yet. We ask the kernel with 
+    // move_pages, which only queries the nodes if no target nodes are given.
+    int majority_node(const void *data, std::size_t bytes) const {
+#ifdef __linux__
+        constexpr std::size_t MAX_SAMPLES = 64;
+        if (num_nodes() <= 1 || bytes == 0) {
+            return -1;
+        }
+
+        const std::uintptr_t page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+        const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(data) / page_size;
+        const std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(data) + bytes - 1) / page_size;
+        const std::size_t num_pages = last - first + 1;
+        const std::size_t num_samples = std::min(MAX_SAMPLES, num_pages);
+
+        std::array<void*, MAX_SAMPLES> pages;
+        std::array<int, MAX_SAMPLES> status;
+        for (std::size_t i = 0; i < num_samples; i++) {
+            pages[i] = reinterpret_cast<void*>((first + i * num_pages / num_samples) * page_size);
+        }
+        if (syscall(SYS_move_pages, 0, num_samples, pages.data(), nullptr, status.data(), 0) != 0) {
+            return -1;
+        }
+
+        std::vector<std::size_t> counts(num_nodes(), 0);
+        for (std::size_t i = 0; i < num_samples; i++) {
+            auto it = std::find(node_ids.begin(), node_ids.end(), status[i]);
+            if (it != node_ids.end()) {
+                counts[it - node_ids.begin()]++;
+            }
+        }
+        auto best = std::max_element(counts.begin(), counts.end());
+        return (*best == 0) ? -1 : static_cast<int>(best - counts.begin());
+#else
+        (void) data;
+        (void) bytes;
+        return -1;
+#endif
+    }
+};
+
+// Scheduling placement counts: the tasks, and the items they cover, which were placed on a node 
+// (see work_stealing_scheduler::spawn_on_node) and executed by a worker of this node or another 
+// one. This is not a measurement of page locality: it tells where the placed tasks ran, not where 
+// their memory accesses went. Tasks spawned with spawn (stripes, pieces, small stashes) are not 
+// counted and the kernel may still migrate pages.
+struct numa_placement_stats {
+    std::size_t local_tasks = 0;
+    std::size_t remote_tasks = 0;
+    std::size_t local_items = 0;
+    std::size_t remote_items = 0;
+};
+
+// A small work-stealing scheduler. The worker threads are started once and sleep between two calls 
+// of run. The thread which calls run takes part as worker 0. Every worker has its own Chase-Lev 
+// deque; a task may spawn further tasks onto the deque of the worker that executes it and idle 
+// workers steal from the others. run returns once all tasks, including the spawned ones, are done.
+// Only one thread at a time may call run.
+// With a numa_topology the workers are pinned to the nodes round-robin, starting with the node the 
+// constructing thread runs on (which becomes worker 0 but is not pinned). Tasks can then be placed 
+// on a node; they wait in an inbox of that node and its workers take them before they steal. 
+// Stealing itself prefers workers of the same node.
+class work_stealing_scheduler {
+public:
+    // A task gets the id of the worker that executes it
+    using task = std::function<void(std::size_t)>;
+
+    explicit work_stealing_scheduler(std::size_t num_threads) : work_stealing_scheduler(num_threads, numa_topology {}) {}
+
+    work_stealing_scheduler(std::size_t num_threads, const numa_topology &numa) : topology(numa) {
+        num_workers = std::max<std::size_t>(num_threads, 1);
+        const std::size_t num_nodes = std::max<std::size_t>(topology.num_nodes(), 1);
+
+        std::size_t first_node = 0;
+#ifdef __linux__
+        first_node = static_cast<std::size_t>(std::max(topology.node_of_cpu(sched_getcpu()), 0));
+#endif
+        for (std::size_t w = 0; w < num_workers; w++) {
+            deques.push_back(std::make_unique<chase_lev_deque<task>>());
+            worker_nodes.push_back((first_node + w) % num_nodes);
+        }
+        for (std::size_t n = 0; n < num_nodes; n++) {
+            inboxes.push_back(std::make_unique<node_inbox>());
+        }
+
+        // Victims of the same node come first
+        for (std::size_t w = 0; w < num_workers; w++) {
+            std::vector<std::size_t> order;
+            for (std::size_t i = 1; i < num_workers; i++) {
+                order.push_back((w + i) % num_workers);
+            }
+            std::stable_partition(order.begin(), order.end(), [&](std::size_t v) { return worker_nodes[v] == worker_nodes[w]; });
+            victims.push_back(std::move(order));
+        }
+
+        for (std::size_t w = 1; w < num_workers; w++) {
+            threads.emplace_back([this, w] { thread_main(w); });
+#ifdef __linux__
+            if (topology.num_nodes() > 1) {
+                const std::vector<int> &cpus = topology.node_cpus[worker_nodes[w]];
+                cpu_set_t cpu_set;
+                CPU_ZERO(&cpu_set);
+                CPU_SET(cpus[(w / num_nodes) % cpus.size()], &cpu_set);
+                // Pinning is only a hint, the worker still runs correctly if this fails
+                pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpu_set), &cpu_set);
+            }
+#endif
+        }
+    }
+
+    ~work_stealing_scheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake_up.notify_all();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    work_stealing_scheduler(const work_stealing_scheduler&) = delete;
+    work_stealing_scheduler& operator=(const work_stealing_scheduler&) = delete;
+
+    std::size_t num_threads() const { return num_workers; }
+    const numa_topology &numa() const { return topology; }
+
+    numa_placement_stats placement_stats() const {
+        numa_placement_stats result;
+        result.local_tasks = local_tasks.load(std::memory_order_relaxed);
+        result.remote_tasks = remote_tasks.load(std::memory_order_relaxed);
+        result.local_items = local_items.load(std::memory_order_relaxed);
+        result.remote_items = remote_items.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // May only be called from within a task which runs on worker worker_id
+    void spawn(std::size_t worker_id, task t) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        deques[worker_id]->push(new task(std::move(t)));
+    }
+
+    // Places a task which works on num_items items on the given node (an index of numa()). It 
+    // may be called from within any task.
+    void spawn_on_node(std::size_t node, std::size_t num_items, task t) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        node_inbox &inbox = *inboxes[node % inboxes.size()];
+        std::lock_guard<std::mutex> lock(inbox.mutex);
+        inbox.tasks.push_back({new task(std::move(t)), num_items});
+        inbox.size.fetch_add(1, std::memory_order_release);
+    }
+
+    void run(std::vector<task> roots) {
+        if (roots.empty()) {
+            return;
+        }
+
+        // All workers are asleep, hence we may fill their deques
+        pending.store(roots.size(), std::memory_order_relaxed);
+        for (std::size_t i = 0; i < roots.size(); i++) {
+            deques[i % num_workers]->push(new task(std::move(roots[i])));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active_threads = threads.size();
+            epoch++;
+        }
+        wake_up.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        all_asleep.wait(lock, [this] { return active_threads == 0; });
+    }
+
+private:
+    void thread_main(std::size_t worker_id) {
+        std::size_t seen_epoch = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake_up.wait(lock, [&] { return stop || epoch != seen_epoch; });
+                if (stop) {
+                    return;
+                }
+                seen_epoch = epoch;
+            }
+
+            work(worker_id);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active_threads == 0) {
+                all_asleep.notify_all();
+            }
+        }
+    }
+
+    struct node_task {
+        task *t;
+        std::size_t num_items;
+    };
+
+    struct node_inbox {
+        std::mutex mutex;
+        std::deque<node_task> tasks;
+        std::atomic<std::size_t> size {0};
+    };
+
+    task *take_from_inbox(std::size_t node, std::size_t worker_id) {
+        node_inbox &inbox = *inboxes[node];
+        if (inbox.size.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+
+        node_task item;
+        {
+            std::lock_guard<std::mutex> lock(inbox.mutex);
+            if (inbox.tasks.empty()) {
+                return nullptr;
+            }
+            item = inbox.tasks.front();
+            inbox.tasks.pop_front();
+            inbox.size.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        if (node == worker_nodes[worker_id]) {
+            local_tasks.fetch_add(1, std::memory_order_relaxed);
+            local_items.fetch_add(item.num_items, std::memory_order_relaxed);
+        } else {
+            remote_tasks.fetch_add(1, std::memory_order_relaxed);
+            remote_items.fetch_add(item.num_items, std::memory_order_relaxed);
+        }
+        return item.t;
+    }
+
+    // Own deque, inbox of the own node, workers of the own node, then everything else
+    task *find_task(std::size_t worker_id) {
+        const std::size_t node = worker_nodes[worker_id];
+        task *t = deques[worker_id]->pop();
+        if (t == nullptr) {
+            t = take_from_inbox(node, worker_id);
+        }
+
+        const std::vector<std::size_t> &order = victims[worker_id];
+        std::size_t i = 0;
+        for (; t == nullptr && i < order.size() && worker_nodes[order[i]] == node; i++) {
+            t = deques[order[i]]->steal();
+        }
+        for (std::size_t n = 1; t == nullptr && n < inboxes.size(); n++) {
+            t = take_from_inbox((node + n) % inboxes.size(), worker_id);
+        }
+        for (; t == nullptr && i < order.size(); i++) {
+            t = deques[order[i]]->steal();
+        }
+        return t;
+    }
+
+    void work(std::size_t worker_id) {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            task *t = find_task(worker_id);
+
+            if (t == nullptr) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            (*t)(worker_id);
+            delete t;
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    numa_topology topology;
+    std::size_t num_workers;
+    std::vector<std::unique_ptr<chase_lev_deque<task>>> deques;
+    std::vector<std::size_t> worker_nodes;
+    std::vector<std::vector<std::size_t>> victims;
+    std::vector<std::unique_ptr<node_inbox>> inboxes;
+    std::vector<std::thread> threads;
+
+    std::atomic<std::size_t> pending {0};
+    std::atomic<std::size_t> local_tasks {0};
+    std::atomic<std::size_t> remote_tasks {0};
+    std::atomic<std::size_t> local_items {0};
+    std::atomic<std::size_t> remote_items {0};
+
+    std::mutex mutex;
+    std::condition_variable wake_up;
+    std::condition_variable all_asleep;
+    std::size_t epoch = 0;
+    std::size_t active_threads = 0;
+    bool stop = false;
+};
+
+// Swaps the disjoint ranges [first, first + length) and [second, second + length). Such a swap can 
+// be split into independent pieces.
+struct range_swap {
+    std::size_t first;
+    std::size_t second;
+    std::size_t length;
+};
+
+// The swap which moves the block [begin, end) such that it starts at target. The items which are 
+// overwritten by the block end up in the space that is left behind, but not necessarily in the 
+// same order. We only need min(|target - begin|, end - begin) swaps for this.
+inline range_swap shift_block_swap(std::size_t begin, std::size_t end, std::size_t target) {
+    std::size_t length = end - begin;
+    if (target < begin) {
+        std::size_t distance = begin - target;
+        if (distance < length) {
+            return {target, end - distance, distance};
+        }
+        return {begin, target, length};
+    } else if (target > begin) {
+        std::size_t distance = target - begin;
+        if (distance < length) {
+            return {begin, end, distance};
+        }
+        return {begin, target, length};
+    }
+    return {begin, begin, 0};
+}
+
+template<typename T>
+void swap_ranges(std::span<T> data_span, const range_swap &r) {
+    auto it = data_span.begin();
+    std::swap_ranges(it + r.first, it + r.first + r.length, it + r.second);
+}
+
+// Moves the block [begin, end) of data_span such that it starts at target, see shift_block_swap.
+template<typename T>
+void shift_block(std::span<T> data_span, std::size_t begin, std::size_t end, std::size_t target) {
+    swap_ranges(data_span, shift_block_swap(begin, end, target));
+}
+
+// Splits every bucket into stripes.size() consecutive pieces, stripe p consists of the p-th piece 
+// of each bucket. Unlike the contiguous stripes of the parallel rip_shuffle, every stripe can then 
+// be scattered concurrently with the sequential rough scatter and merging them (merge_stripes) 
+// only has to move the staged items, see scatter_shuffle_task.
+template<std::size_t K>
+void init_stripes(std::array<bucket_limits, K> &buckets, std::vector<std::array<bucket_limits, K>> &stripes) {
+    const std::size_t num_stripes = stripes.size();
+    for (std::size_t p = 0; p < num_stripes; p++) {
+        for (std::size_t i = 0; i < K; i++) {
+            std::size_t size = buckets[i].num_total();
+            stripes[p][i].begin = buckets[i].begin + size * p / num_stripes;
+            stripes[p][i].staged = stripes[p][i].begin;
+            stripes[p][i].end = buckets[i].begin + size * (p+1) / num_stripes;
+        }
+    }
+}
+
+// Shifts the placed items of every piece to the front of its global bucket. Only the staged items 
+// are moved around, the placed ones stay where they are unless there are only few of them.
+template<std::size_t K, typename T>
+void merge_stripes(std::span<T> data_span, std::array<bucket_limits, K> &buckets, std::vector<std::array<bucket_limits, K>> &stripes) {
+    for (std::size_t i = 0; i < K; i++) {
+        std::size_t placed_end = buckets[i].begin;
+        for (auto &stripe : stripes) {
+            bucket_limits piece = stripe[i];
+            shift_block(data_span, piece.begin, piece.staged, placed_end);
+            placed_end += piece.num_placed();
+        }
+        buckets[i].staged = placed_end;
+    }
+}
+
+// Plans the parallel counterpart of the two sweeps of rebalance_buckets. After the sweeps the 
+// placed items of bucket i always occupy [F_i, F_i + p_i), where p_i is their number and F_i is 
+// the prefix sum of the final sizes of the buckets left of i. Hence we can move every block of 
+// placed items there with one shift_block; the staged items it displaces end up in the stashes. 
+// A block that moves left may overlap with the old position of its left neighbour if this one 
+// moves left as well, so it has to wait for it (and symmetrically for blocks which move right). 
+// All other moves are disjoint. The moves are returned in waves, the moves of one wave may run 
+// concurrently. buckets is set to the final limits.
+template<std::size_t K>
+std::vector<std::vector<range_swap>> plan_rebalance(std::array<bucket_limits, K> &buckets, const std::array<size_t, K> &final_bucket_sizes) {
+    std::array<std::size_t, K> targets {};
+    for (std::size_t i = 1; i < K; i++) {
+        targets[i] = targets[i-1] + final_bucket_sizes[i-1];
+    }
+    for (auto &target : targets) {
+        target += buckets[0].begin;
+    }
+
+    std::array<std::size_t, K> wave {};
+    std::size_t num_waves = 0;
+    for (std::size_t i = 0; i < K; i++) {
+        if (targets[i] < buckets[i].begin) {
+            wave[i] = (i > 0 && targets[i-1] < buckets[i-1].begin) ? wave[i-1] + 1 : 0;
+            num_waves = std::max(num_waves, wave[i] + 1);
+        }
+    }
+    for (std::size_t i = K; i-- > 0;) {
+        if (targets[i] > buckets[i].begin) {
+            wave[i] = (i+1 < K && targets[i+1] > buckets[i+1].begin) ? wave[i+1] + 1 : 0;
+            num_waves = std::max(num_waves, wave[i] + 1);
+        }
+    }
+
+    std::vector<std::vector<range_swap>> waves(num_waves);
+    for (std::size_t i = 0; i < K; i++) {
+        if (targets[i] != buckets[i].begin) {
+            waves[wave[i]].push_back(shift_block_swap(buckets[i].begin, buckets[i].staged, targets[i]));
+        }
+        std::size_t num_placed = buckets[i].num_placed();
+        buckets[i].begin = targets[i];
+        buckets[i].staged = targets[i] + num_placed;
+        buckets[i].end = targets[i] + final_bucket_sizes[i];
+    }
+    return waves;
+}
+
+// Cuts the swaps of a wave into pieces of at most piece_size items.
+inline std::vector<range_swap> split_range_swaps(const std::vector<range_swap> &swaps, std::size_t piece_size) {
+    std::vector<range_swap> pieces;
+    for (const range_swap &r : swaps) {
+        for (std::size_t offset = 0; offset < r.length; offset += piece_size) {
+            pieces.push_back({r.first + offset, r.second + offset, std::min(piece_size, r.length - offset)});
+        }
+    }
+    return pieces;
+}
+
+// Waits for a whole subtree of tasks. Every task of the subtree holds one reference to count, a 
+// task takes another one for each child before it spawns it and drops its own when it is done. 
+// The task which drops the last reference runs the continuation.
+struct subtree_join {
+    std::atomic<std::size_t> count {1};
+    work_stealing_scheduler::task continuation;
+};
+
+inline void release_join(const std::shared_ptr<subtree_join> &join, std::size_t worker_id) {
+    if (join != nullptr && join->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        join->continuation(worker_id);
+    }
+}
+
+// State of one inner node of the recursion tree of parallel_inplace_scatter_shuffle. It is shared 
+// by the stripe tasks of the node; the last one to finish continues with the fine scatter. join is 
+// the subtree the node belongs to, if anyone waits for it.
+template<typename T, typename RNG>
+struct scatter_shuffle_node {
+    std::span<T> data_span;
+    std::uint64_t seed;
+    RNG gen;
+    std::array<bucket_limits, NUM_BUCKETS> buckets;
+    std::vector<std::array<bucket_limits, NUM_BUCKETS>> stripes;
+    std::atomic<std::size_t> stripes_left;
+    std::vector<std::vector<range_swap>> waves;
+    std::size_t next_wave = 0;
+    std::atomic<std::size_t> pieces_left;
+    std::shared_ptr<subtree_join> join;
+};
+
+template<typename T, typename RNG>
+void scatter_shuffle_task(work_stealing_scheduler &scheduler, std::size_t worker_id, std::span<T> data_span, std::uint64_t seed, std::shared_ptr<subtree_join> join);
+
+// Last step of an inner node: spawning the buckets. Buckets with at most PARALLEL_THRESHOLD items 
+// are not worth a task, they are shuffled right away. If the scheduler knows the NUMA topology, a 
+// bucket is placed on the node which holds most of its pages. Buckets whose pages are interleaved 
+// or unknown are spawned as usual.
+template<typename T, typename RNG>
+void shuffle_buckets(work_stealing_scheduler &scheduler, std::size_t worker_id, scatter_shuffle_node<T, RNG> &node) {
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        std::span bucket_span = node.data_span.subspan(node.buckets[i].begin, node.buckets[i].num_total());
+        if (bucket_span.size() > PARALLEL_THRESHOLD) {
+            std::uint64_t seed = derive_seed(node.seed, i);
+            std::shared_ptr<subtree_join> join = node.join;
+            if (join != nullptr) {
+                join->count.fetch_add(1, std::memory_order_relaxed);
+            }
+            auto bucket_task = [&scheduler, bucket_span, seed, join](std::size_t w) {
+                scatter_shuffle_task<T, RNG>(scheduler, w, bucket_span, seed, join);
+            };
+            int numa_node = scheduler.numa().majority_node(bucket_span.data(), bucket_span.size_bytes());
+            if (numa_node >= 0) {
+                scheduler.spawn_on_node(numa_node, bucket_span.size(), bucket_task);
+            } else {
+                scheduler.spawn(worker_id, bucket_task);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        std::span bucket_span = node.data_span.subspan(node.buckets[i].begin, node.buckets[i].num_total());
+        if (bucket_span.size() <= PARALLEL_THRESHOLD) {
+            RNG gen = seeded_generator<RNG>(derive_seed(node.seed, i));
+            // Unknown caches, i.e. NUM_BUCKETS on all levels, the permutation must not depend on the machine
+            inplace_scatter_shuffle(bucket_span, gen, cache_sizes {});
+        }
+    }
+    release_join(node.join, worker_id);
+}
+
+// Last part of the fine scatter of an inner node, then the buckets. A stash with more than 
+// PARALLEL_THRESHOLD items is compacted as usual but shuffled by a subtree of tasks of its own; the 
+// buckets are spawned once the whole subtree is done. Stashes which do not fit into the last 
+// bucket are rare and still shuffled sequentially by noncontinuous_fisher_yates_shuffle.
+template<typename T, typename RNG>
+void shuffle_node_stash(work_stealing_scheduler &scheduler, std::size_t worker_id, std::shared_ptr<scatter_shuffle_node<T, RNG>> node) {
+    std::size_t stash_size = 0;
+    for (auto &bucket : node->buckets) {
+        stash_size += bucket.num_staged();
+    }
+    if (stash_size <= PARALLEL_THRESHOLD || stash_size > node->buckets[NUM_BUCKETS - 1].num_total()) {
+        shuffle_stashes(node->data_span, node->buckets, node->gen);
+        shuffle_buckets(scheduler, worker_id, *node);
+        return;
+    }
+
+    compact_stashes(node->data_span, node->buckets, stash_size);
+    auto stash_join = std::make_shared<subtree_join>();
+    stash_join->continuation = [&scheduler, node, stash_size](std::size_t w) {
+        compact_stashes(node->data_span, node->buckets, stash_size);
+        shuffle_buckets(scheduler, w, *node);
+    };
+    // The buckets and stripes use the indices below NUM_BUCKETS + MAX_STRIPES
+    std::uint64_t stash_seed = derive_seed(node->seed, NUM_BUCKETS + MAX_STRIPES);
+    scatter_shuffle_task<T, RNG>(scheduler, worker_id, node->data_span.last(stash_size), stash_seed, stash_join);
+}
+
+// Runs the remaining waves of plan_rebalance. A wave with more than REBALANCE_PIECE_SIZE items is 
+// split into one task per piece and the last piece to finish continues with the next wave. The 
+// pieces are spawned as usual: they are short, and a piece swaps two ranges which may lie on 
+// different memory nodes, so placing it would cost a move_pages call without a clear winner.
+template<typename T, typename RNG>
+void rebalance_node(work_stealing_scheduler &scheduler, std::size_t worker_id, std::shared_ptr<scatter_shuffle_node<T, RNG>> node) {
+    while (node->next_wave < node->waves.size()) {
+        std::vector<range_swap> pieces = split_range_swaps(node->waves[node->next_wave], REBALANCE_PIECE_SIZE);
+        node->next_wave++;
+        if (pieces.size() <= 1) {
+            for (const range_swap &piece : pieces) {
+                swap_ranges(node->data_span, piece);
+            }
+            continue;
+        }
+
+        node->pieces_left.store(pieces.size(), std::memory_order_relaxed);
+        auto piece_task = [&scheduler, node](std::size_t w, range_swap piece) {
+            swap_ranges(node->data_span, piece);
+            if (node->pieces_left.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                rebalance_node(scheduler, w, node);
+            }
+        };
+        for (std::size_t j = 1; j < pieces.size(); j++) {
+            range_swap piece = pieces[j];
+            scheduler.spawn(worker_id, [piece_task, piece](std::size_t w) { piece_task(w, piece); });
+        }
+        piece_task(worker_id, pieces[0]);
+        return;
+    }
+    shuffle_node_stash(scheduler, worker_id, node);
+}
+
+// Second half of an inner node: fine scatter, then the buckets. The bucket boundaries are moved 
+// with the waves of plan_rebalance instead of the sequential sweeps.
+template<typename T, typename RNG>
+void finish_scatter_shuffle_node(work_stealing_scheduler &scheduler, std::size_t worker_id, std::shared_ptr<scatter_shuffle_node<T, RNG>> node) {
+    if (!node->stripes.empty()) {
+        merge_stripes(node->data_span, node->buckets, node->stripes);
+    }
+    auto final_bucket_sizes = draw_final_bucket_sizes(node->buckets, node->gen);
+    node->waves = plan_rebalance(node->buckets, final_bucket_sizes);
+    rebalance_node(scheduler, worker_id, node);
+}
+
+// One node of the recursion tree as a task. Small nodes are shuffled sequentially. Large nodes 
+// scatter in stripes, one task per stripe. The number of stripes only depends on the size of the 
+// node and the seeds of the stripes and of the buckets are derived from the seed of the node, see 
+// derive_seed. Therefore the result of a node is the same for any number of threads and any order 
+// in which the tasks are executed.
+template<typename T, typename RNG>
+void scatter_shuffle_task(work_stealing_scheduler &scheduler, std::size_t worker_id, std::span<T> data_span, std::uint64_t seed, std::shared_ptr<subtree_join> join) {
+    if (data_span.size() <= PARALLEL_THRESHOLD) {
+        RNG gen = seeded_generator<RNG>(seed);
+        // Unknown caches, i.e. NUM_BUCKETS on all levels, the permutation must not depend on the machine
+        inplace_scatter_shuffle(data_span, gen, cache_sizes {});
+        release_join(join, worker_id);
+        return;
+    }
+
+    auto node = std::make_shared<scatter_shuffle_node<T, RNG>>();
+    node->data_span = data_span;
+    node->seed = seed;
+    node->gen = seeded_generator<RNG>(seed);
+    node->join = std::move(join);
+    init_buckets(data_span.size(), node->buckets);
+
+    const std::size_t num_stripes = std::min(MAX_STRIPES, data_span.size() / PARALLEL_THRESHOLD);
+    if (num_stripes <= 1) {
+        random_word_buffer<RNG> buffered_gen(node->gen);
+        cycle_rough_scatter(data_span, node->buckets, buffered_gen);
+        finish_scatter_shuffle_node(scheduler, worker_id, node);
+        return;
+    }
+
+    node->stripes.resize(num_stripes);
+    init_stripes(node->buckets, node->stripes);
+    node->stripes_left.store(num_stripes, std::memory_order_relaxed);
+
+    auto stripe_task = [&scheduler, node](std::size_t w, std::size_t p) {
+        // The buckets use the indices below NUM_BUCKETS
+        RNG stripe_gen = seeded_generator<RNG>(derive_seed(node->seed, NUM_BUCKETS + p));
+        random_word_buffer<RNG> buffered_gen(stripe_gen);
+        cycle_rough_scatter(node->data_span, node->stripes[p], buffered_gen);
+        if (node->stripes_left.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            finish_scatter_shuffle_node(scheduler, w, node);
+        }
+    };
+    // Unlike the buckets the stripes are not placed with spawn_on_node. A stripe has a piece in 
+    // every bucket and thus spans the same pages as the whole node, so no memory node is better 
+    // than the one of this worker, whose neighbours steal them first anyway.
+    for (std::size_t p = 1; p < num_stripes; p++) {
+        scheduler.spawn(worker_id, [stripe_task, p](std::size_t w) { stripe_task(w, p); });
+    }
+    stripe_task(worker_id, 0);
+}
+
+// Deterministic parallel shuffle. Every node of the recursion tree derives its generator from seed 
+// and its position in the tree, hence the permutation only depends on seed (and RNG) but not on 
+// the number of workers of scheduler.
+template<typename RNG, typename T>
+void deterministic_parallel_inplace_scatter_shuffle(std::span<T> data_span, std::uint64_t seed, work_stealing_scheduler &scheduler) {
+    static_assert(PARALLEL_THRESHOLD >= NUM_BUCKETS, "Every stripe needs at least one item per bucket");
+
+    if (data_span.empty()) {
+        return;
+    }
+
+    scheduler.run({[&scheduler, data_span, seed](std::size_t w) {
+        scatter_shuffle_task<T, RNG>(scheduler, w, data_span, seed, nullptr);
+    }});
+}
+
+// Same as above with a temporary scheduler. Usage: 
+// deterministic_parallel_inplace_scatter_shuffle<pcg64>(data_span, seed, num_threads)
+template<typename RNG, typename T>
+void deterministic_parallel_inplace_scatter_shuffle(std::span<T> data_span, std::uint64_t seed, std::size_t num_threads) {
+    work_stealing_scheduler scheduler(num_threads);
+    deterministic_parallel_inplace_scatter_shuffle<RNG>(data_span, seed, scheduler);
+}
+
+// Shuffles data_span on the workers of scheduler. The root seed is the only value drawn from gen.
+template<typename T, typename RNG>
+void parallel_inplace_scatter_shuffle(std::span<T> data_span, RNG &gen, work_stealing_scheduler &scheduler) {
+    deterministic_parallel_inplace_scatter_shuffle<RNG>(data_span, random_word_64(gen), scheduler);
+}
+
+// Parallel variant of inplace_scatter_shuffle. Every node of the recursion tree is a task of a 
+// work_stealing_scheduler with num_threads workers. Subproblems with at most PARALLEL_THRESHOLD 
+// items are shuffled sequentially.
+template<typename T, typename RNG>
+void parallel_inplace_scatter_shuffle(std::span<T> data_span, RNG &gen, std::size_t num_threads) {
+    if (num_threads <= 1 || data_span.size() <= PARALLEL_THRESHOLD) {
+        inplace_scatter_shuffle(data_span, gen);
+        return;
+    }
+
+    work_stealing_scheduler scheduler(num_threads);
+    parallel_inplace_scatter_shuffle(data_span, gen, scheduler);
+}
+
+// Parallel MergeShuffle. data_span is cut into a power of two number of blocks, at least one per 
+// thread, which are shuffled concurrently. Then the blocks are merged pairwise level by level, the 
+// merges of one level run concurrently. Every block and every merge gets its own generator which 
+// is derived from one seed drawn from gen. The last merge is done by a single thread.
+template<typename T, typename RNG>
+void parallel_merge_shuffle(std::span<T> data_span, RNG &gen, std::size_t num_threads) {
+    if (num_threads <= 1 || data_span.size() <= THRESHOLD) {
+        merge_shuffle(data_span, gen);
+        return;
+    }
+
+    const std::size_t num_blocks = std::bit_ceil(num_threads);
+    const std::size_t n = data_span.size();
+    auto block_begin = [&](std::size_t b) { return n * b / num_blocks; };
+    const std::uint64_t seed = random_word_64(gen);
+
+    fork_join(num_threads, [&](std::size_t t) {
+        for (std::size_t b = t; b < num_blocks; b += num_threads) {
+            RNG block_gen = seeded_generator<RNG>(derive_seed(seed, b));
+            merge_shuffle(data_span.subspan(block_begin(b), block_begin(b+1) - block_begin(b)), block_gen);
+        }
+    });
+
+    std::size_t level = 1;
+    for (std::size_t width = 1; width < num_blocks; width *= 2, level++) {
+        const std::size_t num_merges = num_blocks / (2 * width);
+        const std::size_t num_merge_threads = std::min(num_threads, num_merges);
+        fork_join(num_merge_threads, [&](std::size_t t) {
+            for (std::size_t m = t; m < num_merges; m += num_merge_threads) {
+                std::size_t begin = block_begin(2 * m * width);
+                std::size_t mid = block_begin((2 * m + 1) * width);
+                std::size_t end = block_begin((2 * m + 2) * width);
+                RNG merge_gen = seeded_generator<RNG>(derive_seed(seed, level * num_blocks + m));
+                merge_shuffled_blocks(data_span.subspan(begin, end - begin), mid - begin, merge_gen);
+            }
+        });
+    }
+}
+
+// NUMA-aware variant of parallel_inplace_scatter_shuffle. The workers are pinned to the memory 
+// nodes found in /sys/devices/system/node and the recursion of every bucket runs on the node which 
+// holds most of its pages. The permutation is the same as without NUMA awareness. Returns how many 
+// of the buckets (and items) placed on a node were shuffled by a worker of this node. On machines 
+// with a single node this is the plain parallel shuffle.
+template<typename T, typename RNG>
+numa_placement_stats numa_parallel_inplace_scatter_shuffle(std::span<T> data_span, RNG &gen, std::size_t num_threads) {
+    work_stealing_scheduler scheduler(num_threads, numa_topology::detect());
+    parallel_inplace_scatter_shuffle(data_span, gen, scheduler);
+    return scheduler.placement_stats();
+}
+
+// A reusable parallel shuffler for many calls in a row. The worker threads are created once and 
+// sleep between two calls, so a call only pays for waking them up. The executor owns one generator 
+// from which it draws the root seed of every call; all generators of the tasks are derived from 
+// these seeds (see scatter_shuffle_task). The workers have no generator streams or scratch state 
+// of their own. A long-lived generator per worker would make the result depend on which worker 
+// executes which task. The scratch of a task (buckets, blocks of random words) lives on its stack, 
+// and the nodes of the recursion tree are allocated per call. Example:
+//     shuffle_executor<pcg64> executor(num_threads, seed);
+//     executor.shuffle(data_span);
+template<typename RNG>
+class shuffle_executor {
+public:
+    shuffle_executor(std::size_t num_threads, std::uint64_t seed) 
+        : scheduler(num_threads), gen(seeded_generator<RNG>(seed)) {}
+
+    std::size_t num_threads() const { return scheduler.num_threads(); }
+
+    // Small spans are shuffled by the calling thread right away
+    template<typename T>
+    void shuffle(std::span<T> data_span) {
+        if (data_span.size() <= PARALLEL_THRESHOLD) {
+            // NUM_BUCKETS on all levels as in the parallel shuffle, see scatter_shuffle_task
+            inplace_scatter_shuffle(data_span, gen, cache_sizes {});
+            return;
+        }
+        deterministic_parallel_inplace_scatter_shuffle<RNG>(data_span, random_word_64(gen), scheduler);
+    }
+
+    // Shuffles all spans within one run of the scheduler, every span is a root task. This keeps all 
+    // workers busy even if every single span is too small to be split.
+    template<typename T>
+    void shuffle_many(const std::vector<std::span<T>> &spans) {
+        std::uint64_t batch_seed = random_word_64(gen);
+
+        std::vector<work_stealing_scheduler::task> roots;
+        roots.reserve(spans.size());
+        for (std::size_t i = 0; i < spans.size(); i++) {
+            std::span<T> data_span = spans[i];
+            std::uint64_t seed = derive_seed(batch_seed, i);
+            roots.push_back([this, data_span, seed](std::size_t w) {
+                scatter_shuffle_task<T, RNG>(scheduler, w, data_span, seed, nullptr);
+            });
+        }
+        scheduler.run(std::move(roots));
+    }
+
+private:
+    work_stealing_scheduler scheduler;
+    RNG gen;
+};
+
 #endif /* CIP_SHUFFLE_HPP */
\ No newline at end of file
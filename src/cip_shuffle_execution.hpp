@@ -0,0 +1,37 @@
+#ifndef CIP_SHUFFLE_EXECUTION_HPP
+#define CIP_SHUFFLE_EXECUTION_HPP
+
+#include <version>
+
+#include <cip_shuffle.hpp>
+
+// The overloads with an execution policy live in their own header since <execution> is not
+// available everywhere, and libstdc++ needs TBB at link time for it if the TBB headers are
+// installed. Only code which uses the overloads has to pay for that.
+#ifdef __cpp_lib_execution
+#include <execution>
+
+// Overloads in the style of the parallel algorithms of the standard library, e.g.
+// inplace_scatter_shuffle(std::execution::par, data_span, gen):
+//     seq        the sequential inplace_scatter_shuffle
+//     par        parallel_inplace_scatter_shuffle with one thread per hardware thread
+//     unseq      the same as seq
+//     par_unseq  the same as par
+// There are no vectorized kernels. The unsequenced policies are only accepted so that code written 
+// for the standard algorithms compiles; they run the plain paths and give the same permutations 
+// as seq and par.
+template<typename ExecutionPolicy, typename T, typename RNG>
+    requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+void inplace_scatter_shuffle(ExecutionPolicy &&, std::span<T> data_span, RNG &gen) {
+    using policy = std::remove_cvref_t<ExecutionPolicy>;
+    if constexpr (std::is_same_v<policy, std::execution::parallel_policy>
+                  || std::is_same_v<policy, std::execution::parallel_unsequenced_policy>) {
+        // hardware_concurrency may return 0 if it is unknown
+        parallel_inplace_scatter_shuffle(data_span, gen, std::max<std::size_t>(std::thread::hardware_concurrency(), 1));
+    } else {
+        inplace_scatter_shuffle(data_span, gen);
+    }
+}
+#endif
+
+#endif /* CIP_SHUFFLE_EXECUTION_HPP */
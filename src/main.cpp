@@ -4,6 +4,7 @@
 #include <fstream>
 #include <chrono>
 #include <cip_shuffle.hpp>
+#include <philox.hpp>
 
 #include "pcg-cpp-0.98/include/pcg_random.hpp"
 
@@ -633,9 +634,402 @@ void benchmark_buffered_fy_64() {
     }
 } 
 
+void benchmark_merge_shuffle() {
+    benchmark_param benchmark;
+    benchmark.function_name = "merge_shuffle";
+    benchmark.prng_name = "pcg64";
+    benchmark.num_buckets = NUM_BUCKETS;
+    benchmark.buffer_size = BUFFER_SIZE;
+    benchmark.threshold = THRESHOLD;
+    benchmark.buffer_threshold = BUFFER_THRESHOLD;
+    benchmark.min_exp = 0;
+    benchmark.max_exp = 33; // 29 for my mac, 30 for my windows machine, 33 for the uni-machine
+    benchmark.size = 0;
+    benchmark.total_runs = 0;
+    benchmark.total_runtime = std::chrono::nanoseconds::zero();
+    benchmark.DEFAULT_RUNS = 5;
+    benchmark.MIN_DURATION = std::chrono::milliseconds(100);
+
+    pcg_extras::seed_seq_from<std::random_device> seed_source;
+    pcg64 generator(seed_source);
+
+    std::filesystem::path path = create_csv_path(benchmark.num_buckets, benchmark.buffer_size, benchmark.threshold);
+
+    std::fstream my_file;
+    my_file.open(path, std::ios::out);
+    if (my_file.is_open()) {
+        std::cout << "Starting benchmark with " << benchmark.num_buckets << " buckets...\n";
+
+        // Creating CSV headers
+        benchmark.create_header(my_file);
+
+        // Initiliazing vector with maximum size
+        std::vector<std::size_t> vec(std::pow(2, benchmark.max_exp));
+        std::iota(vec.begin(), vec.end(), 0);
+        std::span vector_span {vec};
+
+        for (std::size_t i = benchmark.min_exp; i <= benchmark.max_exp; i++) {
+            benchmark.size = std::pow(2, i);
+            std::cout << std::setw(static_cast<size_t>(std::log10(benchmark.max_exp))) << i + 1 << "/" << benchmark.max_exp + 1 << " ";
+            std::cout << "Setting size = " << std::setw(static_cast<size_t>(std::log10(std::pow(2, benchmark.max_exp)))) << benchmark.size;
+            std::cout << " " << "which needs " << sizeof(size_t) * benchmark.size << " Bytes of storage.\n";
+
+            // Getting the first size elements
+            std::span view = vector_span.first(benchmark.size);
+
+            benchmark.total_runs = benchmark.DEFAULT_RUNS;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < benchmark.total_runs; i++) {
+                    merge_shuffle(view, generator);
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                benchmark.total_runtime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+                if (benchmark.total_runtime >= static_cast<std::chrono::nanoseconds>(benchmark.MIN_DURATION)) {
+                    benchmark.write_to_file(my_file);
+                    std::cout << "Total runtime: " << std::setw(18) << benchmark.total_runtime.count() << " ns" << "\n";
+                    break;
+                }
+                benchmark.total_runs *= 10;
+            }
+            std::cout << "\n";
+        }
+
+        std::cout << "Benchmark done!" << std::endl;
+
+        my_file.close();
+    } else {
+        std::cout << "ERROR: File not found!" << "\n";
+    }
+} 
+
+void benchmark_parallel_merge_shuffle() {
+    benchmark_param benchmark;
+    benchmark.function_name = "parallel_merge_shuffle";
+    benchmark.prng_name = "pcg64";
+    benchmark.num_buckets = NUM_BUCKETS;
+    benchmark.buffer_size = BUFFER_SIZE;
+    benchmark.threshold = THRESHOLD;
+    benchmark.buffer_threshold = BUFFER_THRESHOLD;
+    benchmark.min_exp = 0;
+    benchmark.max_exp = 33; // 29 for my mac, 30 for my windows machine, 33 for the uni-machine
+    benchmark.size = 0;
+    benchmark.total_runs = 0;
+    benchmark.total_runtime = std::chrono::nanoseconds::zero();
+    benchmark.DEFAULT_RUNS = 5;
+    benchmark.MIN_DURATION = std::chrono::milliseconds(100);
+
+    pcg_extras::seed_seq_from<std::random_device> seed_source;
+    pcg64 generator(seed_source);
+    const std::size_t num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+    std::filesystem::path path = create_csv_path(benchmark.num_buckets, benchmark.buffer_size, benchmark.threshold);
+
+    std::fstream my_file;
+    my_file.open(path, std::ios::out);
+    if (my_file.is_open()) {
+        std::cout << "Starting benchmark with " << benchmark.num_buckets << " buckets...\n";
+
+        // Creating CSV headers
+        benchmark.create_header(my_file);
+
+        // Initiliazing vector with maximum size
+        std::vector<std::size_t> vec(std::pow(2, benchmark.max_exp));
+        std::iota(vec.begin(), vec.end(), 0);
+        std::span vector_span {vec};
+
+        for (std::size_t i = benchmark.min_exp; i <= benchmark.max_exp; i++) {
+            benchmark.size = std::pow(2, i);
+            std::cout << std::setw(static_cast<size_t>(std::log10(benchmark.max_exp))) << i + 1 << "/" << benchmark.max_exp + 1 << " ";
+            std::cout << "Setting size = " << std::setw(static_cast<size_t>(std::log10(std::pow(2, benchmark.max_exp)))) << benchmark.size;
+            std::cout << " " << "which needs " << sizeof(size_t) * benchmark.size << " Bytes of storage.\n";
+
+            // Getting the first size elements
+            std::span view = vector_span.first(benchmark.size);
+
+            benchmark.total_runs = benchmark.DEFAULT_RUNS;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < benchmark.total_runs; i++) {
+                    parallel_merge_shuffle(view, generator, num_threads);
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                benchmark.total_runtime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+                if (benchmark.total_runtime >= static_cast<std::chrono::nanoseconds>(benchmark.MIN_DURATION)) {
+                    benchmark.write_to_file(my_file);
+                    std::cout << "Total runtime: " << std::setw(18) << benchmark.total_runtime.count() << " ns" << "\n";
+                    break;
+                }
+                benchmark.total_runs *= 10;
+            }
+            std::cout << "\n";
+        }
+
+        std::cout << "Benchmark done!" << std::endl;
+
+        my_file.close();
+    } else {
+        std::cout << "ERROR: File not found!" << "\n";
+    }
+} 
+
+void benchmark_parallel_inplace_scatter_shuffle() {
+    benchmark_param benchmark;
+    benchmark.function_name = "parallel_inplace_scatter_shuffle";
+    benchmark.prng_name = "pcg64";
+    benchmark.num_buckets = NUM_BUCKETS;
+    benchmark.buffer_size = BUFFER_SIZE;
+    benchmark.threshold = THRESHOLD;
+    benchmark.buffer_threshold = BUFFER_THRESHOLD;
+    benchmark.min_exp = 0;
+    benchmark.max_exp = 33; // 29 for my mac, 30 for my windows machine, 33 for the uni-machine
+    benchmark.size = 0;
+    benchmark.total_runs = 0;
+    benchmark.total_runtime = std::chrono::nanoseconds::zero();
+    benchmark.DEFAULT_RUNS = 5;
+    benchmark.MIN_DURATION = std::chrono::milliseconds(100);
+
+    pcg_extras::seed_seq_from<std::random_device> seed_source;
+    pcg64 generator(seed_source);
+    const std::size_t num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    // The workers are started once and not in every run
+    work_stealing_scheduler scheduler(num_threads);
+
+    std::filesystem::path path = create_csv_path(benchmark.num_buckets, benchmark.buffer_size, benchmark.threshold);
+
+    std::fstream my_file;
+    my_file.open(path, std::ios::out);
+    if (my_file.is_open()) {
+        std::cout << "Starting benchmark with " << benchmark.num_buckets << " buckets...\n";
+
+        // Creating CSV headers
+        benchmark.create_header(my_file);
+
+        // Initiliazing vector with maximum size
+        std::vector<std::size_t> vec(std::pow(2, benchmark.max_exp));
+        std::iota(vec.begin(), vec.end(), 0);
+        std::span vector_span {vec};
+
+        for (std::size_t i = benchmark.min_exp; i <= benchmark.max_exp; i++) {
+            benchmark.size = std::pow(2, i);
+            std::cout << std::setw(static_cast<size_t>(std::log10(benchmark.max_exp))) << i + 1 << "/" << benchmark.max_exp + 1 << " ";
+            std::cout << "Setting size = " << std::setw(static_cast<size_t>(std::log10(std::pow(2, benchmark.max_exp)))) << benchmark.size;
+            std::cout << " " << "which needs " << sizeof(size_t) * benchmark.size << " Bytes of storage.\n";
+
+            // Getting the first size elements
+            std::span view = vector_span.first(benchmark.size);
+
+            benchmark.total_runs = benchmark.DEFAULT_RUNS;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < benchmark.total_runs; i++) {
+                    parallel_inplace_scatter_shuffle(view, generator, scheduler);
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                benchmark.total_runtime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+                if (benchmark.total_runtime >= static_cast<std::chrono::nanoseconds>(benchmark.MIN_DURATION)) {
+                    benchmark.write_to_file(my_file);
+                    std::cout << "Total runtime: " << std::setw(18) << benchmark.total_runtime.count() << " ns" << "\n";
+                    break;
+                }
+                benchmark.total_runs *= 10;
+            }
+            std::cout << "\n";
+        }
+
+        std::cout << "Benchmark done!" << std::endl;
+
+        my_file.close();
+    } else {
+        std::cout << "ERROR: File not found!" << "\n";
+    }
+} 
+
+void benchmark_inplace_scatter_shuffle_philox() {
+    benchmark_param benchmark;
+    benchmark.function_name = "inplace_scatter_shuffle";
+    benchmark.prng_name = "philox4x64";
+    benchmark.num_buckets = NUM_BUCKETS;
+    benchmark.buffer_size = BUFFER_SIZE;
+    benchmark.threshold = THRESHOLD;
+    benchmark.buffer_threshold = BUFFER_THRESHOLD;
+    benchmark.min_exp = 0;
+    benchmark.max_exp = 33; // 29 for my mac, 30 for my windows machine, 33 for the uni-machine
+    benchmark.size = 0;
+    benchmark.total_runs = 0;
+    benchmark.total_runtime = std::chrono::nanoseconds::zero();
+    benchmark.DEFAULT_RUNS = 5;
+    benchmark.MIN_DURATION = std::chrono::milliseconds(100);
+
+    pcg_extras::seed_seq_from<std::random_device> seed_source;
+    philox4x64 generator(seed_source);
+
+    std::filesystem::path path = create_csv_path(benchmark.num_buckets, benchmark.buffer_size, benchmark.threshold);
+
+    std::fstream my_file;
+    my_file.open(path, std::ios::out);
+    if (my_file.is_open()) {
+        std::cout << "Starting benchmark with " << benchmark.num_buckets << " buckets...\n";
+
+        // Creating CSV headers
+        benchmark.create_header(my_file);
+
+        // Initiliazing vector with maximum size
+        std::vector<std::size_t> vec(std::pow(2, benchmark.max_exp));
+        std::iota(vec.begin(), vec.end(), 0);
+        std::span vector_span {vec};
+
+        for (std::size_t i = benchmark.min_exp; i <= benchmark.max_exp; i++) {
+            benchmark.size = std::pow(2, i);
+            std::cout << std::setw(static_cast<size_t>(std::log10(benchmark.max_exp))) << i + 1 << "/" << benchmark.max_exp + 1 << " ";
+            std::cout << "Setting size = " << std::setw(static_cast<size_t>(std::log10(std::pow(2, benchmark.max_exp)))) << benchmark.size;
+            std::cout << " " << "which needs " << sizeof(size_t) * benchmark.size << " Bytes of storage.\n";
+
+            // Getting the first size elements
+            std::span view = vector_span.first(benchmark.size);
+
+            benchmark.total_runs = benchmark.DEFAULT_RUNS;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < benchmark.total_runs; i++) {
+                    inplace_scatter_shuffle(view, generator);
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                benchmark.total_runtime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+                if (benchmark.total_runtime >= static_cast<std::chrono::nanoseconds>(benchmark.MIN_DURATION)) {
+                    benchmark.write_to_file(my_file);
+                    std::cout << "Total runtime: " << std::setw(18) << benchmark.total_runtime.count() << " ns" << "\n";
+                    break;
+                }
+                benchmark.total_runs *= 10;
+            }
+            std::cout << "\n";
+        }
+
+        std::cout << "Benchmark done!" << std::endl;
+
+        my_file.close();
+    } else {
+        std::cout << "ERROR: File not found!" << "\n";
+    }
+} 
+
 //----------------------------------------------------------------------------------------------------------------
 
+// Per-call overhead on small inputs: the executor keeps its workers between calls, while
+// deterministic_parallel_inplace_scatter_shuffle starts a scheduler in every call
+void benchmark_shuffle_executor() {
+    benchmark_param benchmark;
+    benchmark.prng_name = "pcg64";
+    benchmark.num_buckets = NUM_BUCKETS;
+    benchmark.buffer_size = BUFFER_SIZE;
+    benchmark.threshold = THRESHOLD;
+    benchmark.buffer_threshold = BUFFER_THRESHOLD;
+    benchmark.min_exp = 0;
+    benchmark.max_exp = LOG_PARALLEL_THRESHOLD + 2;
+    benchmark.size = 0;
+    benchmark.total_runs = 0;
+    benchmark.total_runtime = std::chrono::nanoseconds::zero();
+    benchmark.DEFAULT_RUNS = 5;
+    benchmark.MIN_DURATION = std::chrono::milliseconds(100);
+
+    pcg_extras::seed_seq_from<std::random_device> seed_source;
+    pcg64 generator(seed_source);
+    const std::size_t num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    shuffle_executor<pcg64> executor(num_threads, random_word_64(generator));
+
+    std::filesystem::path path = create_csv_path(benchmark.num_buckets, benchmark.buffer_size, benchmark.threshold);
+
+    std::fstream my_file;
+    my_file.open(path, std::ios::out);
+    if (my_file.is_open()) {
+        std::cout << "Starting benchmark with " << benchmark.num_buckets << " buckets...\n";
+
+        // Creating CSV headers
+        benchmark.create_header(my_file);
+
+        // Initiliazing vector with maximum size
+        std::vector<std::size_t> vec(std::pow(2, benchmark.max_exp));
+        std::iota(vec.begin(), vec.end(), 0);
+        std::span vector_span {vec};
+
+        // Runs shuffle until MIN_DURATION is reached and writes one row
+        auto run = [&](const std::string &function_name, auto shuffle) {
+            benchmark.function_name = function_name;
+            benchmark.total_runs = benchmark.DEFAULT_RUNS;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < benchmark.total_runs; i++) {
+                    shuffle();
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                benchmark.total_runtime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+                if (benchmark.total_runtime >= static_cast<std::chrono::nanoseconds>(benchmark.MIN_DURATION)) {
+                    benchmark.write_to_file(my_file);
+                    std::cout << std::setw(48) << function_name << ": " << std::setw(18) << benchmark.total_runtime.count() / benchmark.total_runs << " ns per call" << "\n";
+                    break;
+                }
+                benchmark.total_runs *= 10;
+            }
+        };
+
+        for (std::size_t i = benchmark.min_exp; i <= benchmark.max_exp; i++) {
+            benchmark.size = std::pow(2, i);
+            std::cout << std::setw(static_cast<size_t>(std::log10(benchmark.max_exp))) << i + 1 << "/" << benchmark.max_exp + 1 << " ";
+            std::cout << "Setting size = " << std::setw(static_cast<size_t>(std::log10(std::pow(2, benchmark.max_exp)))) << benchmark.size;
+            std::cout << " " << "which needs " << sizeof(size_t) * benchmark.size << " Bytes of storage.\n";
+
+            // Getting the first size elements
+            std::span view = vector_span.first(benchmark.size);
+            std::vector<std::span<std::size_t>> views {view};
+
+            run("shuffle_executor", [&] { executor.shuffle(view); });
+            // Always goes through the workers, also below PARALLEL_THRESHOLD
+            run("shuffle_executor_many", [&] { executor.shuffle_many(views); });
+            run("deterministic_parallel_inplace_scatter_shuffle", [&] {
+                deterministic_parallel_inplace_scatter_shuffle<pcg64>(view, random_word_64(generator), num_threads);
+            });
+            std::cout << "\n";
+        }
+
+        std::cout << "Benchmark done!" << std::endl;
+
+        my_file.close();
+    } else {
+        std::cout << "ERROR: File not found!" << "\n";
+    }
+}
+
+// Selects the benchmark of main, set by BENCHMARK in src/CMakeLists.txt
+#ifdef BENCHMARK_VAR
+constexpr int BENCHMARK = BENCHMARK_VAR;
+#else
+constexpr int BENCHMARK = 0;
+#endif
+
 int main() {
-    benchmark_inplace_scatter_shuffle();
+    switch (BENCHMARK) {
+        case 0: benchmark_inplace_scatter_shuffle(); break;
+        case 1: benchmark_std_shuffle(); break;
+        case 2: benchmark_fy_shuffle(); break;
+        case 3: benchmark_fy_shuffle_32(); break;
+        case 4: benchmark_fy_shuffle_64(); break;
+        case 5: benchmark_buffered_fy(); break;
+        case 6: benchmark_buffered_fy_32(); break;
+        case 7: benchmark_buffered_fy_64(); break;
+        case 8: benchmark_merge_shuffle(); break;
+        case 9: benchmark_parallel_merge_shuffle(); break;
+        case 10: benchmark_parallel_inplace_scatter_shuffle(); break;
+        case 11: benchmark_inplace_scatter_shuffle_philox(); break;
+        case 12: benchmark_shuffle_executor(); break;
+        default:
+            std::cout << "ERROR: Unknown benchmark " << BENCHMARK << "\n";
+            return 1;
+    }
     return 0;
 }
@@ -0,0 +1,133 @@
+#ifndef PHILOX_HPP
+#define PHILOX_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+// Counter-based generator Philox4x64-10. Word i of the stream with key (seed, stream) is word
+// i % 4 of the block philox4x64::block({i / 4, 0, 0, 0}, {seed, stream}). There is no state besides
+// the position, hence discard and creating another stream are O(1). Every bucket, thread or node
+// of a recursion can get its own stream by picking a stream id, no seeding or jumping required.
+// John K. Salmon, Mark A. Moraes, Ron O. Dror, and David E. Shaw. 2011. Parallel Random Numbers: As Easy as 1, 2, 3. SC '11. https://doi.org/10.1145/2063384.2063405
+class philox4x64 {
+public:
+    using result_type = std::uint64_t;
+    using counter_type = std::array<std::uint64_t, 4>;
+    using key_type = std::array<std::uint64_t, 2>;
+
+    static constexpr std::size_t ROUNDS = 10;
+
+    static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    philox4x64() : philox4x64(0) {}
+
+    explicit philox4x64(std::uint64_t seed, std::uint64_t stream = 0) : key {seed, stream} {}
+
+    // For seeded_generator
+    template<typename SeedSeq, typename = decltype(std::declval<SeedSeq&>().generate(std::declval<std::uint32_t*>(), std::declval<std::uint32_t*>()))>
+    explicit philox4x64(SeedSeq &seed_sequence) {
+        std::array<std::uint32_t, 4> seeds;
+        seed_sequence.generate(seeds.begin(), seeds.end());
+        key[0] = static_cast<std::uint64_t>(seeds[0]) | (static_cast<std::uint64_t>(seeds[1]) << 32);
+        key[1] = static_cast<std::uint64_t>(seeds[2]) | (static_cast<std::uint64_t>(seeds[3]) << 32);
+    }
+
+    // The stream with the same seed and the given id, starting at its beginning
+    philox4x64 substream(std::uint64_t stream) const {
+        return philox4x64(key[0], stream);
+    }
+
+    // Stream selection as in pcg, used by split_generator
+    static constexpr bool can_specify_stream = true;
+
+    std::uint64_t stream() const { return key[1]; }
+
+    result_type operator()() {
+        if (index == 4) {
+            words = block({position, position_high, 0, 0}, key);
+            advance_position(1);
+            index = 0;
+        }
+        return words[index++];
+    }
+
+    // Skips z words in O(1)
+    void discard(unsigned long long z) {
+        // Words left in the current block
+        std::uint64_t left = 4 - index;
+        if (z < left) {
+            index += z;
+            return;
+        }
+        z -= left;
+        advance_position(z / 4);
+        index = 4;
+        if (z % 4 != 0) {
+            operator()();
+            index = z % 4;
+        }
+    }
+
+    // Writes the next n words to out. This gives the same words as n calls of operator().
+    void fill(result_type *out, std::size_t n) {
+        for (; n > 0 && index < 4; n--) {
+            *out++ = words[index++];
+        }
+        for (; n >= 4; n -= 4) {
+            counter_type b = block({position, position_high, 0, 0}, key);
+            advance_position(1);
+            for (std::size_t i = 0; i < 4; i++) {
+                out[i] = b[i];
+            }
+            out += 4;
+        }
+        for (; n > 0; n--) {
+            *out++ = operator()();
+        }
+    }
+
+    // The Philox bijection
+    static counter_type block(counter_type counter, key_type k) {
+        constexpr std::uint64_t M0 = 0xD2E7470EE14C6C93ULL;
+        constexpr std::uint64_t M1 = 0xCA5A826395121157ULL;
+        constexpr std::uint64_t W0 = 0x9E3779B97F4A7C15ULL;
+        constexpr std::uint64_t W1 = 0xBB67AE8584CAA73BULL;
+
+        for (std::size_t r = 0; r < ROUNDS; r++) {
+            if (r > 0) {
+                k[0] += W0;
+                k[1] += W1;
+            }
+            __uint128_t p0 = static_cast<__uint128_t>(M0) * counter[0];
+            __uint128_t p1 = static_cast<__uint128_t>(M1) * counter[2];
+            counter = {
+                static_cast<std::uint64_t>(p1 >> 64) ^ counter[1] ^ k[0],
+                static_cast<std::uint64_t>(p1),
+                static_cast<std::uint64_t>(p0 >> 64) ^ counter[3] ^ k[1],
+                static_cast<std::uint64_t>(p0)
+            };
+        }
+        return counter;
+    }
+
+private:
+    void advance_position(std::uint64_t blocks) {
+        std::uint64_t old = position;
+        position += blocks;
+        if (position < old) {
+            position_high++;
+        }
+    }
+
+    key_type key;
+    // Index of the next block as a 128-bit number
+    std::uint64_t position = 0;
+    std::uint64_t position_high = 0;
+    counter_type words {};
+    std::size_t index = 4;
+};
+
+#endif /* PHILOX_HPP */
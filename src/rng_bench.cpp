@@ -0,0 +1,235 @@
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <cip_shuffle.hpp>
+#include <philox.hpp>
+#include <xoshiro_simd.hpp>
+#include <chacha.hpp>
+
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+// Benchmarks of the generators themselves. All results are written to one CSV file with the schema
+// of cip_shuffle_bench. There are three kinds of rows, told apart by the function column:
+// - words: raw throughput, integers is the number of 64-bit words per run. The throughput in GB/s 
+//   is 8 * integers * total_runs / total_runtime.
+// - my_uniform_int_distribution_32/2^k and my_uniform_int_distribution_64/2^k: bounded integers
+//   with bound 2^k + 1, integers is the number of draws per run.
+// - inplace_scatter_shuffle: end-to-end shuffles, integers is the number of items as in
+//   cip_shuffle_bench.
+// Narrower generators (pcg32, std::minstd_rand) are measured through random_word_64, i.e. as the
+// shuffles see them.
+
+std::filesystem::path create_csv_path() {
+    // Folder wher all benchmarks should be stored
+    std::filesystem::path path = "../benchmarks/cpp";
+
+    // We transform date and time to YYYYMMDD-HHMMSS as in cip_shuffle_bench
+    std::time_t rawtime;
+    std::tm* timeinfo;
+    char buffer [80];
+    std::time(&rawtime);
+    timeinfo = std::localtime(&rawtime);
+    std::strftime(buffer,80,"%Y%m%d-%H%M%S", timeinfo);
+
+    std::string filename = std::string(buffer)
+                           + "-nb=" + std::to_string(NUM_BUCKETS)
+                           + "-bf=" + std::to_string(BUFFER_SIZE)
+                           + "-th=" + std::to_string(THRESHOLD)
+                           + "-rng-cpp"
+                           + ".csv";
+
+    path /= filename;
+
+    return path;
+}
+
+//----------------------------------------------------------------------------------------------------------------
+
+struct benchmark_param {
+    std::string function_name;
+    std::string prng_name;
+    std::size_t num_buckets = NUM_BUCKETS;
+    std::size_t buffer_size = BUFFER_SIZE;
+    std::size_t threshold = THRESHOLD;
+    std::size_t buffer_threshold = BUFFER_THRESHOLD;
+    std::size_t min_exp = 0;
+    std::size_t max_exp = 0;
+    std::size_t size = 0;
+    std::size_t total_runs = 0;
+    std::chrono::nanoseconds total_runtime = std::chrono::nanoseconds::zero();
+    std::size_t DEFAULT_RUNS = 5;
+    std::chrono::milliseconds MIN_DURATION = std::chrono::milliseconds(100);
+
+    void create_header(std::fstream& file) {
+        // Creating CSV headers
+        file << "function," << "prng," << "buckets," << "buffer," << "threshold," << "buffer_threshold,"
+             << "min_exp," << "max_exp," << "integers," << "total_runs," << "total_runtime" << "\n";
+    }
+
+    void write_to_file(std::fstream& file) {
+        file << function_name << ",";
+        file << prng_name << ",";
+        file << num_buckets << ",";
+        file << buffer_size << ",";
+        file << threshold << ",";
+        file << buffer_threshold << ",";
+        file << min_exp << ",";
+        file << max_exp << ",";
+        file << size << ",";
+        file << total_runs << ",";
+        file << total_runtime.count() << "\n";
+    }
+};
+
+// Calls run() total_runs times and increases total_runs tenfold until this takes at least
+// MIN_DURATION, then writes the row
+template<typename F>
+void measure(benchmark_param &benchmark, std::fstream &file, F run) {
+    benchmark.total_runs = benchmark.DEFAULT_RUNS;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < benchmark.total_runs; i++) {
+            run();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        benchmark.total_runtime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        if (benchmark.total_runtime >= static_cast<std::chrono::nanoseconds>(benchmark.MIN_DURATION)) {
+            benchmark.write_to_file(file);
+            std::cout << std::setw(36) << benchmark.function_name << " " << std::setw(18) << benchmark.prng_name
+                      << " " << std::setw(12) << benchmark.size << ": "
+                      << static_cast<double>(benchmark.total_runtime.count()) / static_cast<double>(benchmark.total_runs * benchmark.size)
+                      << " ns per integer\n";
+            break;
+        }
+        benchmark.total_runs *= 10;
+    }
+}
+
+// Keeps the compiler from removing the loops of the benchmarks
+volatile std::uint64_t sink;
+
+constexpr std::size_t LOG_WORDS = 20;
+constexpr std::size_t LOG_DRAWS = 16;
+// Exponents k of the bounds 2^k + 1, the ones up to 31 are used for both distributions
+constexpr std::array<std::size_t, 13> BOUND_EXPS = {1, 4, 8, 12, 16, 20, 24, 28, 31, 40, 48, 56, 62};
+
+template<typename RNG>
+void benchmark_words(const std::string &prng_name, RNG &generator, std::fstream &file) {
+    benchmark_param benchmark;
+    benchmark.function_name = "words";
+    benchmark.prng_name = prng_name;
+    benchmark.min_exp = LOG_WORDS;
+    benchmark.max_exp = LOG_WORDS;
+    benchmark.size = std::size_t(1) << LOG_WORDS;
+
+    measure(benchmark, file, [&]() {
+        std::uint64_t acc = 0;
+        for (std::size_t i = 0; i < benchmark.size; i++) {
+            acc += random_word_64(generator);
+        }
+        sink = acc;
+    });
+}
+
+template<typename RNG>
+void benchmark_uniform_int_distribution(const std::string &prng_name, RNG &generator, std::fstream &file) {
+    benchmark_param benchmark;
+    benchmark.prng_name = prng_name;
+    benchmark.min_exp = BOUND_EXPS.front();
+    benchmark.max_exp = BOUND_EXPS.back();
+    benchmark.size = std::size_t(1) << LOG_DRAWS;
+
+    for (std::size_t k : BOUND_EXPS) {
+        const std::uint64_t bound = (std::uint64_t(1) << k) + 1;
+        if (k < 32) {
+            benchmark.function_name = "my_uniform_int_distribution_32/2^" + std::to_string(k);
+            measure(benchmark, file, [&]() {
+                std::uint64_t acc = 0;
+                for (std::size_t i = 0; i < benchmark.size; i++) {
+                    acc += my_uniform_int_distribution_32(static_cast<std::uint32_t>(bound), generator);
+                }
+                sink = acc;
+            });
+        }
+        benchmark.function_name = "my_uniform_int_distribution_64/2^" + std::to_string(k);
+        measure(benchmark, file, [&]() {
+            std::uint64_t acc = 0;
+            for (std::size_t i = 0; i < benchmark.size; i++) {
+                acc += my_uniform_int_distribution_64(bound, generator);
+            }
+            sink = acc;
+        });
+    }
+}
+
+template<typename RNG>
+void benchmark_inplace_scatter_shuffle(const std::string &prng_name, RNG &generator, std::span<std::size_t> vector_span, std::fstream &file) {
+    benchmark_param benchmark;
+    benchmark.function_name = "inplace_scatter_shuffle";
+    benchmark.prng_name = prng_name;
+    benchmark.min_exp = 0;
+    benchmark.max_exp = std::bit_width(vector_span.size()) - 1;
+
+    for (std::size_t i = benchmark.min_exp; i <= benchmark.max_exp; i++) {
+        benchmark.size = std::size_t(1) << i;
+        std::span view = vector_span.first(benchmark.size);
+        measure(benchmark, file, [&]() {
+            inplace_scatter_shuffle(view, generator);
+        });
+    }
+}
+
+template<typename RNG>
+void benchmark_generator(const std::string &prng_name, RNG generator, std::span<std::size_t> vector_span, std::fstream &file) {
+    benchmark_words(prng_name, generator, file);
+    benchmark_uniform_int_distribution(prng_name, generator, file);
+    benchmark_inplace_scatter_shuffle(prng_name, generator, vector_span, file);
+}
+
+// The standard engines do not accept pcg_extras::seed_seq_from, hence all generators are seeded 
+// through std::seed_seq
+template<typename RNG>
+RNG random_generator() {
+    std::random_device rd;
+    std::seed_seq seed_sequence {rd(), rd(), rd(), rd(), rd(), rd(), rd(), rd()};
+    return RNG(seed_sequence);
+}
+
+//----------------------------------------------------------------------------------------------------------------
+
+int main() {
+    // 26 keeps a full run of all generators below an hour, cip_shuffle_bench goes up to 33
+    constexpr std::size_t max_exp = 26;
+
+    std::filesystem::path path = create_csv_path();
+    std::fstream my_file;
+    my_file.open(path, std::ios::out);
+    if (!my_file.is_open()) {
+        std::cout << "ERROR: File not found!" << "\n";
+        return 1;
+    }
+    benchmark_param().create_header(my_file);
+
+    // Initiliazing vector with maximum size
+    std::vector<std::size_t> vec(std::size_t(1) << max_exp);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::span vector_span {vec};
+
+    benchmark_generator("pcg64", random_generator<pcg64>(), vector_span, my_file);
+    benchmark_generator("pcg64_fast", random_generator<pcg64_fast>(), vector_span, my_file);
+    benchmark_generator("pcg32", random_generator<pcg32>(), vector_span, my_file);
+    benchmark_generator("mt19937_64", random_generator<std::mt19937_64>(), vector_span, my_file);
+    benchmark_generator("minstd_rand", random_generator<std::minstd_rand>(), vector_span, my_file);
+    benchmark_generator("xoshiro256pp", random_generator<xoshiro256pp_simd<1>>(), vector_span, my_file);
+    benchmark_generator("xoshiro256pp_simd", random_generator<xoshiro256pp_simd<8>>(), vector_span, my_file);
+    benchmark_generator("philox4x64", random_generator<philox4x64>(), vector_span, my_file);
+    benchmark_generator("chacha12", random_generator<chacha12>(), vector_span, my_file);
+    benchmark_generator("chacha20", random_generator<chacha20>(), vector_span, my_file);
+
+    std::cout << "Benchmark done!" << std::endl;
+    my_file.close();
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <cip_shuffle.hpp>
+
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+// Benchmarks of the rough scatter kernels on their own. All results are written to one CSV file
+// with the schema of cip_shuffle_bench, the function column names the kernel and integers is the
+// number of items. Every run starts with fresh buckets on the items left by the previous run.
+// The prefetch distance and block size are in the file name, the executables are built for several 
+// prefetch distances.
+
+std::filesystem::path create_csv_path() {
+    // Folder wher all benchmarks should be stored
+    std::filesystem::path path = "../benchmarks/cpp";
+
+    // We transform date and time to YYYYMMDD-HHMMSS as in cip_shuffle_bench
+    std::time_t rawtime;
+    std::tm* timeinfo;
+    char buffer [80];
+    std::time(&rawtime);
+    timeinfo = std::localtime(&rawtime);
+    std::strftime(buffer,80,"%Y%m%d-%H%M%S", timeinfo);
+
+    std::string filename = std::string(buffer)
+                           + "-nb=" + std::to_string(NUM_BUCKETS)
+                           + "-pd=" + std::to_string(PREFETCH_DISTANCE)
+                           + "-bs=" + std::to_string(SCATTER_BLOCK_SIZE)
+                           + "-rough-scatter-cpp"
+                           + ".csv";
+
+    path /= filename;
+
+    return path;
+}
+
+//----------------------------------------------------------------------------------------------------------------
+
+struct benchmark_param {
+    std::string function_name;
+    std::string prng_name = "pcg64";
+    std::size_t num_buckets = NUM_BUCKETS;
+    std::size_t buffer_size = BUFFER_SIZE;
+    std::size_t threshold = THRESHOLD;
+    std::size_t buffer_threshold = BUFFER_THRESHOLD;
+    std::size_t min_exp = 0;
+    std::size_t max_exp = 0;
+    std::size_t size = 0;
+    std::size_t total_runs = 0;
+    std::chrono::nanoseconds total_runtime = std::chrono::nanoseconds::zero();
+    std::size_t DEFAULT_RUNS = 5;
+    std::chrono::milliseconds MIN_DURATION = std::chrono::milliseconds(100);
+
+    void create_header(std::fstream& file) {
+        // Creating CSV headers
+        file << "function," << "prng," << "buckets," << "buffer," << "threshold," << "buffer_threshold,"
+             << "min_exp," << "max_exp," << "integers," << "total_runs," << "total_runtime" << "\n";
+    }
+
+    void write_to_file(std::fstream& file) {
+        file << function_name << ",";
+        file << prng_name << ",";
+        file << num_buckets << ",";
+        file << buffer_size << ",";
+        file << threshold << ",";
+        file << buffer_threshold << ",";
+        file << min_exp << ",";
+        file << max_exp << ",";
+        file << size << ",";
+        file << total_runs << ",";
+        file << total_runtime.count() << "\n";
+    }
+};
+
+// Calls run() total_runs times and increases total_runs tenfold until this takes at least
+// MIN_DURATION, then writes the row
+template<typename F>
+void measure(benchmark_param &benchmark, std::fstream &file, F run) {
+    benchmark.total_runs = benchmark.DEFAULT_RUNS;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < benchmark.total_runs; i++) {
+            run();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        benchmark.total_runtime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        if (benchmark.total_runtime >= static_cast<std::chrono::nanoseconds>(benchmark.MIN_DURATION)) {
+            benchmark.write_to_file(file);
+            std::cout << std::setw(28) << benchmark.function_name << " " << std::setw(12) << benchmark.size << ": "
+                      << static_cast<double>(benchmark.total_runtime.count()) / static_cast<double>(benchmark.total_runs * benchmark.size)
+                      << " ns per integer\n";
+            break;
+        }
+        benchmark.total_runs *= 10;
+    }
+}
+
+// Runs kernel(data_span, buckets, gen) on the first 2^i items for all i up to max_exp. Sizes below
+// NUM_BUCKETS would leave buckets empty.
+template<typename F>
+void benchmark_kernel(const std::string &function_name, F kernel, std::span<std::size_t> vector_span, std::fstream &file) {
+    benchmark_param benchmark;
+    benchmark.function_name = function_name;
+    benchmark.min_exp = LOG_NUM_BUCKETS;
+    benchmark.max_exp = std::bit_width(vector_span.size()) - 1;
+
+    pcg_extras::seed_seq_from<std::random_device> seed_source;
+    pcg64 generator(seed_source);
+    random_word_buffer<pcg64> buffered_gen(generator);
+
+    for (std::size_t i = benchmark.min_exp; i <= benchmark.max_exp; i++) {
+        benchmark.size = std::size_t(1) << i;
+        std::span view = vector_span.first(benchmark.size);
+        measure(benchmark, file, [&]() {
+            std::array<bucket_limits, NUM_BUCKETS> buckets;
+            init_buckets(view.size(), buckets);
+            kernel(view, buckets, buffered_gen);
+        });
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------
+
+int main() {
+    // Far beyond the last level cache of the machines we use, cip_shuffle_bench goes up to 33
+    constexpr std::size_t max_exp = 28;
+
+    std::filesystem::path path = create_csv_path();
+    std::fstream my_file;
+    my_file.open(path, std::ios::out);
+    if (!my_file.is_open()) {
+        std::cout << "ERROR: File not found!" << "\n";
+        return 1;
+    }
+    benchmark_param().create_header(my_file);
+
+    // Initiliazing vector with maximum size
+    std::vector<std::size_t> vec(std::size_t(1) << max_exp);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::span vector_span {vec};
+
+    using buckets_type = std::array<bucket_limits, NUM_BUCKETS>;
+    using gen_type = random_word_buffer<pcg64>;
+    benchmark_kernel("rough_scatter", [](std::span<std::size_t> data_span, buckets_type &buckets, gen_type &gen) {
+        rough_scatter(data_span, buckets, gen);
+    }, vector_span, my_file);
+    benchmark_kernel("prefetching_rough_scatter", [](std::span<std::size_t> data_span, buckets_type &buckets, gen_type &gen) {
+        prefetching_rough_scatter(data_span, buckets, gen);
+    }, vector_span, my_file);
+    benchmark_kernel("cycle_rough_scatter", [](std::span<std::size_t> data_span, buckets_type &buckets, gen_type &gen) {
+        cycle_rough_scatter(data_span, buckets, gen);
+    }, vector_span, my_file);
+    benchmark_kernel("block_rough_scatter", [](std::span<std::size_t> data_span, buckets_type &buckets, gen_type &gen) {
+        block_rough_scatter(data_span, buckets, gen);
+    }, vector_span, my_file);
+
+    std::cout << "Benchmark done!" << std::endl;
+    my_file.close();
+    return 0;
+}
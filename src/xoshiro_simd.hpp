@@ -0,0 +1,204 @@
+#ifndef XOSHIRO_SIMD_HPP
+#define XOSHIRO_SIMD_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+    #include <immintrin.h>
+#endif
+
+// LANES interleaved xoshiro256++ generators which are advanced together. The states are stored
+// lane by lane (structure of arrays), so one step of all lanes maps to a few vector instructions:
+// one register per 8 lanes with AVX-512 and one per 4 lanes with AVX2. Without these instruction
+// sets (e.g. without -march=native) the plain loop is used, which compilers vectorize as well.
+// The output is the interleaving of the lanes, word k comes from lane k % LANES. Lane l starts l
+// jumps of 2^128 steps after lane 0, hence the lanes never overlap.
+// David Blackman and Sebastiano Vigna. 2021. Scrambled Linear Pseudorandom Number Generators. ACM Trans. Math. Softw. 47, 4, Article 36. https://doi.org/10.1145/3460772
+//
+// It can be used as RNG everywhere in cip_shuffle.hpp. fill writes blocks of words directly, this
+// is what random_word_buffer uses to refill.
+template<std::size_t LANES = 8>
+class xoshiro256pp_simd {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    xoshiro256pp_simd() : xoshiro256pp_simd(0x853c49e6748fea9bULL) {}
+
+    // The state of lane 0 is expanded from seed with SplitMix64 as recommended by the authors
+    explicit xoshiro256pp_simd(std::uint64_t seed) {
+        std::array<std::uint64_t, 4> state;
+        for (auto &word : state) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+        init_lanes(state);
+    }
+
+    // For seeded_generator
+    template<typename SeedSeq, typename = decltype(std::declval<SeedSeq&>().generate(std::declval<std::uint32_t*>(), std::declval<std::uint32_t*>()))>
+    explicit xoshiro256pp_simd(SeedSeq &seed_sequence) {
+        std::array<std::uint32_t, 8> seeds;
+        seed_sequence.generate(seeds.begin(), seeds.end());
+        std::array<std::uint64_t, 4> state;
+        for (std::size_t i = 0; i < 4; i++) {
+            state[i] = static_cast<std::uint64_t>(seeds[2*i]) | (static_cast<std::uint64_t>(seeds[2*i + 1]) << 32);
+        }
+        init_lanes(state);
+    }
+
+    // Lane 0 starts with the given state, which must not be all zero
+    static xoshiro256pp_simd from_state(const std::array<std::uint64_t, 4> &state) {
+        xoshiro256pp_simd gen;
+        gen.init_lanes(state);
+        return gen;
+    }
+
+    result_type operator()() {
+        if (index == LANES) {
+            step(block.data());
+            index = 0;
+        }
+        return block[index++];
+    }
+
+    // Writes the next n words to out. This gives the same words as n calls of operator().
+    void fill(result_type *out, std::size_t n) {
+        for (; n > 0 && index < LANES; n--) {
+            *out++ = block[index++];
+        }
+        for (; n >= LANES; n -= LANES) {
+            step(out);
+            out += LANES;
+        }
+        if (n > 0) {
+            step(block.data());
+            std::memcpy(out, block.data(), n * sizeof(result_type));
+            index = n;
+        }
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // One step of a single scalar generator
+    static std::uint64_t next(std::array<std::uint64_t, 4> &s) {
+        const std::uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Advances s by 2^128 steps
+    static void jump(std::array<std::uint64_t, 4> &s) {
+        constexpr std::array<std::uint64_t, 4> JUMP = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        std::array<std::uint64_t, 4> jumped {};
+        for (std::uint64_t word : JUMP) {
+            for (int b = 0; b < 64; b++) {
+                if (word & (std::uint64_t(1) << b)) {
+                    for (std::size_t i = 0; i < 4; i++) {
+                        jumped[i] ^= s[i];
+                    }
+                }
+                next(s);
+            }
+        }
+        s = jumped;
+    }
+
+    void init_lanes(std::array<std::uint64_t, 4> state) {
+        for (std::size_t l = 0; l < LANES; l++) {
+            for (std::size_t i = 0; i < 4; i++) {
+                s[i][l] = state[i];
+            }
+            jump(state);
+        }
+        index = LANES;
+    }
+
+    // Advances all lanes by one step and writes their outputs to out[0, LANES)
+    void step(result_type *out) {
+        [[maybe_unused]] constexpr std::size_t AVX512_END = LANES / 8 * 8;
+        [[maybe_unused]] constexpr std::size_t AVX2_END = LANES / 4 * 4;
+        std::size_t l = 0;
+#if defined(__AVX512F__)
+        // The maskz variants with a full mask avoid -Wuninitialized false positives of GCC 12
+        for (; l < AVX512_END; l += 8) {
+            __m512i s0 = _mm512_loadu_si512(&s[0][l]);
+            __m512i s1 = _mm512_loadu_si512(&s[1][l]);
+            __m512i s2 = _mm512_loadu_si512(&s[2][l]);
+            __m512i s3 = _mm512_loadu_si512(&s[3][l]);
+            __m512i result = _mm512_add_epi64(_mm512_maskz_rol_epi64(0xff, _mm512_add_epi64(s0, s3), 23), s0);
+            __m512i t = _mm512_maskz_slli_epi64(0xff, s1, 17);
+            s2 = _mm512_xor_si512(s2, s0);
+            s3 = _mm512_xor_si512(s3, s1);
+            s1 = _mm512_xor_si512(s1, s2);
+            s0 = _mm512_xor_si512(s0, s3);
+            s2 = _mm512_xor_si512(s2, t);
+            s3 = _mm512_maskz_rol_epi64(0xff, s3, 45);
+            _mm512_storeu_si512(&s[0][l], s0);
+            _mm512_storeu_si512(&s[1][l], s1);
+            _mm512_storeu_si512(&s[2][l], s2);
+            _mm512_storeu_si512(&s[3][l], s3);
+            _mm512_storeu_si512(out + l, result);
+        }
+#endif
+#if defined(__AVX2__)
+        // AVX2 has no 64-bit rotation
+        auto rotl256 = [](__m256i x, int k) {
+            return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+        };
+        for (; l < AVX2_END; l += 4) {
+            __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[0][l]));
+            __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[1][l]));
+            __m256i s2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[2][l]));
+            __m256i s3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[3][l]));
+            __m256i result = _mm256_add_epi64(rotl256(_mm256_add_epi64(s0, s3), 23), s0);
+            __m256i t = _mm256_slli_epi64(s1, 17);
+            s2 = _mm256_xor_si256(s2, s0);
+            s3 = _mm256_xor_si256(s3, s1);
+            s1 = _mm256_xor_si256(s1, s2);
+            s0 = _mm256_xor_si256(s0, s3);
+            s2 = _mm256_xor_si256(s2, t);
+            s3 = rotl256(s3, 45);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[0][l]), s0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[1][l]), s1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[2][l]), s2);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[3][l]), s3);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + l), result);
+        }
+#endif
+        for (; l < LANES; l++) {
+            out[l] = rotl(s[0][l] + s[3][l], 23) + s[0][l];
+            const std::uint64_t t = s[1][l] << 17;
+            s[2][l] ^= s[0][l];
+            s[3][l] ^= s[1][l];
+            s[1][l] ^= s[2][l];
+            s[0][l] ^= s[3][l];
+            s[2][l] ^= t;
+            s[3][l] = rotl(s[3][l], 45);
+        }
+    }
+
+    alignas(64) std::array<std::array<std::uint64_t, LANES>, 4> s;
+    std::array<result_type, LANES> block;
+    std::size_t index = LANES;
+};
+
+#endif /* XOSHIRO_SIMD_HPP */
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+#include "chi_squared_helpers.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+static_assert(LOG_MIN_NUM_BUCKETS == 1 && LOG_MAX_NUM_BUCKETS == 3);
+
+TEST(AdaptiveBucketsTest, ParseCacheSize) {
+    EXPECT_EQ(49152, parse_cache_size("48K"));
+    EXPECT_EQ(std::size_t(2048) << 10, parse_cache_size("2048K"));
+    EXPECT_EQ(std::size_t(105) << 20, parse_cache_size("105M"));
+    EXPECT_EQ(std::size_t(1) << 30, parse_cache_size("1G"));
+    EXPECT_EQ(512, parse_cache_size("512"));
+    EXPECT_EQ(0, parse_cache_size(""));
+    EXPECT_EQ(0, parse_cache_size("unknown"));
+}
+
+TEST(AdaptiveBucketsTest, ChooseLogNumBuckets) {
+    const cache_sizes caches {32 << 10, 1 << 20, 32 << 20};
+
+    // Unknown caches and levels which do not fit into the last cache
+    EXPECT_EQ(LOG_NUM_BUCKETS, choose_log_num_buckets(1 << 20, cache_sizes {}));
+    EXPECT_EQ(LOG_NUM_BUCKETS, choose_log_num_buckets((32 << 20) + 1, caches));
+    EXPECT_EQ(LOG_NUM_BUCKETS, choose_log_num_buckets(std::size_t(1) << 40, caches));
+
+    // The fewest buckets whose subproblems fit into L2
+    EXPECT_EQ(1, choose_log_num_buckets(1 << 20, caches));
+    EXPECT_EQ(1, choose_log_num_buckets(2 << 20, caches));
+    EXPECT_EQ(2, choose_log_num_buckets(4 << 20, caches));
+    EXPECT_EQ(3, choose_log_num_buckets(8 << 20, caches));
+    EXPECT_EQ(3, choose_log_num_buckets(32 << 20, caches));
+
+    // Without L3 L2 is the last cache
+    EXPECT_EQ(1, choose_log_num_buckets(1 << 20, cache_sizes {32 << 10, 1 << 20, 0}));
+    EXPECT_EQ(LOG_NUM_BUCKETS, choose_log_num_buckets((1 << 20) + 1, cache_sizes {32 << 10, 1 << 20, 0}));
+
+    // 8 cache lines do not fit into half of 512 bytes of L1
+    EXPECT_EQ(2, choose_log_num_buckets(8 << 20, cache_sizes {512, 1 << 20, 32 << 20}));
+}
+
+// By default the levels are adapted to the caches of this machine
+TEST(AdaptiveBucketsTest, DefaultUsesDetectedCaches) {
+    std::vector<std::size_t> V(10000);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    pcg64 gen(1234567);
+    inplace_scatter_shuffle(std::span {V}, gen);
+    pcg64 other_gen(1234567);
+    inplace_scatter_shuffle(std::span {W}, other_gen, detected_cache_sizes());
+    EXPECT_EQ(V, W);
+
+    pcg64 bits_gen(7654321);
+    bit_reservoir<pcg64> bits(bits_gen);
+    inplace_scatter_shuffle(std::span {V}, bits);
+    pcg64 other_bits_gen(7654321);
+    bit_reservoir<pcg64> other_bits(other_bits_gen);
+    inplace_scatter_shuffle(std::span {W}, other_bits, detected_cache_sizes());
+    EXPECT_EQ(V, W);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+// The independence test of chi_squared_test for the given caches
+void expect_independent(const cache_sizes &caches) {
+    const std::size_t size = 40;
+    const double confidence = 0.05;
+    std::size_t sample_size = 1000 * size * size;
+
+    pcg64 generator(1234567);
+    independence_test(size, sample_size, confidence, [&](std::span<std::size_t> data_span) {
+        inplace_scatter_shuffle(data_span, generator, caches);
+    });
+}
+
+// 320 bytes do not fit into L3, the first level has 4 buckets and the next ones 2
+TEST(AdaptiveBucketsTest, IndependenceTestMixed) {
+    expect_independent(cache_sizes {0, 64, 256});
+}
+
+// 8 buckets, then Fisher-Yates
+TEST(AdaptiveBucketsTest, IndependenceTestMaxBuckets) {
+    expect_independent(cache_sizes {0, 32, 1024});
+}
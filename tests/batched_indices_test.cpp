@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <boost/math/distributions/chi_squared.hpp>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// Chi-squared test of the joint distribution of the K samples of one batch, which must be uniform 
+// over all bound * (bound - 1) * ... * (bound - K + 1) outcomes.
+template<std::size_t K>
+void joint_uniformity_test(std::uint64_t bound, std::size_t samples_per_cell, double confidence) {
+    pcg64 generator(1234567);
+
+    std::size_t num_cells = 1;
+    for (std::size_t k = 0; k < K; k++) {
+        num_cells *= bound - k;
+    }
+    std::vector<std::size_t> counts(num_cells);
+    const std::size_t sample_size = samples_per_cell * num_cells;
+    for (std::size_t l = 0; l < sample_size; l++) {
+        auto j = batched_uniform_int_distribution<K>(bound, generator);
+        std::size_t cell = 0;
+        for (std::size_t k = 0; k < K; k++) {
+            ASSERT_LT(j[k], bound - k);
+            cell = cell * (bound - k) + j[k];
+        }
+        counts[cell]++;
+    }
+
+    double expected_value = static_cast<double>(samples_per_cell);
+    double chi_squared_value = 0.0;
+    for (std::size_t c : counts) {
+        chi_squared_value += std::pow(static_cast<double>(c) - expected_value, 2) / expected_value;
+    }
+    boost::math::chi_squared distr(static_cast<double>(num_cells - 1));
+    double critical_value = quantile(complement(distr, confidence));
+    EXPECT_LT(chi_squared_value, critical_value);
+}
+
+TEST(BatchedIndicesTest, JointUniformity) {
+    joint_uniformity_test<1>(37, 1000, 0.01);
+    joint_uniformity_test<2>(19, 200, 0.01);
+    joint_uniformity_test<3>(9, 200, 0.01);
+    joint_uniformity_test<4>(7, 200, 0.01);
+}
+
+// The bounds cross the batch sizes 2, 3 and 4
+TEST(BatchedIndicesTest, InRange) {
+    pcg64 generator(1234567);
+    const std::uint64_t bound = BATCH_3_BOUND + 10;
+    std::vector<std::size_t> out(BATCH_3_BOUND);
+    batched_indices(bound, std::span {out}, generator);
+    for (std::size_t k = 0; k < out.size(); k++) {
+        ASSERT_LT(out[k], bound - k);
+    }
+}
+
+// The overload with a runtime count draws the same samples as the one with a fixed K
+TEST(BatchedIndicesTest, RuntimeCount) {
+    pcg64 generator(1234567);
+    pcg64 span_generator(1234567);
+    for (std::size_t l = 0; l < 10000; l++) {
+        auto j = batched_uniform_int_distribution<4>(BATCH_ALL_BOUND, generator);
+        std::array<std::size_t, 4> k;
+        batched_uniform_int_distribution(BATCH_ALL_BOUND, std::span {k}, span_generator);
+        for (std::size_t i = 0; i < 4; i++) {
+            ASSERT_EQ(j[i], k[i]);
+        }
+    }
+}
+
+// Below BATCH_ALL_BOUND Fisher-Yates draws all indices from one word, all 5! permutations have 
+// to be equally likely
+TEST(BatchedIndicesTest, SmallFisherYates) {
+    pcg64 generator(1234567);
+    const std::size_t size = 5;
+    const std::size_t samples_per_cell = 1000;
+    std::map<std::vector<std::size_t>, std::size_t> counts;
+    for (std::size_t l = 0; l < samples_per_cell * 120; l++) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        fisher_yates_shuffle_32(std::span {V}, generator);
+        counts[V]++;
+    }
+    ASSERT_EQ(120, counts.size());
+
+    double expected_value = static_cast<double>(samples_per_cell);
+    double chi_squared_value = 0.0;
+    for (auto &[permutation, c] : counts) {
+        chi_squared_value += std::pow(static_cast<double>(c) - expected_value, 2) / expected_value;
+    }
+    boost::math::chi_squared distr(119.0);
+    double critical_value = quantile(complement(distr, 0.01));
+    EXPECT_LT(chi_squared_value, critical_value);
+}
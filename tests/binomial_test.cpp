@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <boost/math/distributions/binomial.hpp>
+#include <boost/math/distributions/chi_squared.hpp>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// Parameters n and p of the binomial distribution. n * p < 10 uses inversion, otherwise BTRS.
+class BinomialTestFixture : public testing::TestWithParam<std::pair<std::size_t, double>> {
+    protected:
+        int seed;
+        double confidence;
+        std::size_t sample_size;
+
+        void SetUp() override {
+            seed = 1234567;
+            confidence = 0.01;
+            sample_size = 200000;
+        }
+};
+
+// Chi-squared goodness of fit against the exact probability mass function. Outcomes with small 
+// expected counts are pooled into the two tails.
+TEST_P(BinomialTestFixture, GoodnessOfFit) {
+    pcg64 generator(seed);
+    const auto [n, p] = GetParam();
+
+    std::vector<std::size_t> counts(n + 1);
+    for (std::size_t l = 0; l < sample_size; l++) {
+        std::size_t x = binomial(n, p, generator);
+        ASSERT_LE(x, n);
+        counts[x]++;
+    }
+
+    boost::math::binomial_distribution<double> distr(static_cast<double>(n), p);
+    const double samples = static_cast<double>(sample_size);
+    const double min_expected = 20.0;
+
+    double chi_squared_value = 0.0;
+    int num_classes = 0;
+    double pooled_observed = 0.0;
+    double pooled_expected = 0.0;
+    for (std::size_t k = 0; k <= n; k++) {
+        pooled_observed += static_cast<double>(counts[k]);
+        pooled_expected += samples * boost::math::pdf(distr, static_cast<double>(k));
+        // The last class takes whatever is left
+        double rest = samples * boost::math::cdf(boost::math::complement(distr, static_cast<double>(k)));
+        if (pooled_expected >= min_expected && (rest >= min_expected || k == n)) {
+            chi_squared_value += std::pow(pooled_observed - pooled_expected, 2) / pooled_expected;
+            num_classes++;
+            pooled_observed = 0.0;
+            pooled_expected = 0.0;
+        }
+    }
+    if (pooled_expected > 0.0) {
+        chi_squared_value += std::pow(pooled_observed - pooled_expected, 2) / pooled_expected;
+        num_classes++;
+    }
+
+    boost::math::chi_squared chi_distr(num_classes - 1);
+    double critical_value = quantile(complement(chi_distr, confidence));
+    EXPECT_LT(chi_squared_value, critical_value) << num_classes << " classes";
+}
+
+INSTANTIATE_TEST_SUITE_P(BinomialTest,
+                         BinomialTestFixture,
+                         testing::Values(std::make_pair(20, 0.1),
+                                         std::make_pair(1000, 0.005),
+                                         std::make_pair(100, 0.5),
+                                         std::make_pair(1000, 1.0/3),
+                                         std::make_pair(100000, 0.25),
+                                         std::make_pair(500, 0.9)));
+
+TEST(BinomialTest, Extremes) {
+    pcg64 generator(1234567);
+    EXPECT_EQ(0u, binomial(0, 0.5, generator));
+    EXPECT_EQ(0u, binomial(100, 0.0, generator));
+    EXPECT_EQ(100u, binomial(100, 1.0, generator));
+}
+
+TEST(MultinomialTest, SumsToN) {
+    pcg64 generator(1234567);
+    for (std::size_t n : {0, 1, 31, 1000, 1 << 20}) {
+        auto parts = multinomial<32>(n, generator);
+        EXPECT_EQ(n, std::accumulate(parts.begin(), parts.end(), std::size_t {0}));
+    }
+}
+
+// A bit_reservoir assigns few items one by one with log2(K) bits each
+TEST(MultinomialTest, ReservoirAssignsItems) {
+    pcg64 generator(1234567);
+    bit_reservoir<pcg64> bits(generator);
+    for (std::size_t n : {0, 1, 20, 123}) {
+        std::size_t bits_before = bits.bits_consumed();
+        auto parts = multinomial<8>(n, bits);
+        EXPECT_EQ(n, std::accumulate(parts.begin(), parts.end(), std::size_t {0}));
+        EXPECT_EQ(3 * n, bits.bits_consumed() - bits_before);
+    }
+}
+
+// Part 0 of 2 items and 2 parts is 0, 1 or 2 with probabilities 1/4, 1/2 and 1/4
+TEST(MultinomialTest, ReservoirGoodnessOfFit) {
+    pcg64 generator(1234567);
+    bit_reservoir<pcg64> bits(generator);
+    const std::size_t sample_size = 200000;
+    std::array<std::size_t, 3> counts {};
+    for (std::size_t l = 0; l < sample_size; l++) {
+        counts[multinomial<2>(2, bits)[0]]++;
+    }
+
+    const std::array<double, 3> probabilities = {0.25, 0.5, 0.25};
+    double chi_squared_value = 0.0;
+    for (std::size_t k = 0; k < 3; k++) {
+        double expected = static_cast<double>(sample_size) * probabilities[k];
+        chi_squared_value += std::pow(static_cast<double>(counts[k]) - expected, 2) / expected;
+    }
+    boost::math::chi_squared chi_distr(2);
+    double critical_value = quantile(complement(chi_distr, 0.01));
+    EXPECT_LT(chi_squared_value, critical_value);
+}
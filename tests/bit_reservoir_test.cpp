@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+#include "chi_squared_helpers.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+static_assert(random_generator_64<bit_reservoir<pcg64>>);
+static_assert(random_generator_64<bit_reservoir<pcg32>>);
+
+// Pieces of any width concatenated in order have to give the words of the generator
+TEST(BitReservoirTest, ConcatenatesToWords) {
+    pcg64 gen(1234567);
+    pcg64 reference(1234567);
+    bit_reservoir<pcg64> bits(gen);
+
+    const std::array<std::size_t, 8> widths = {1, 5, 64, 3, 17, 63, 2, 29};
+    __uint128_t stream = 0;
+    std::size_t stream_bits = 0;
+    std::uint64_t total_bits = 0;
+    for (std::size_t l = 0; l < 10000; l++) {
+        std::size_t n = widths[l % widths.size()];
+        std::uint64_t x = bits.bits(n);
+        if (n < 64) {
+            ASSERT_LT(x, std::uint64_t(1) << n);
+        }
+        stream |= static_cast<__uint128_t>(x) << stream_bits;
+        stream_bits += n;
+        total_bits += n;
+        if (stream_bits >= 64) {
+            ASSERT_EQ(reference(), static_cast<std::uint64_t>(stream)) << l;
+            stream >>= 64;
+            stream_bits -= 64;
+        }
+    }
+    EXPECT_EQ(total_bits, bits.bits_consumed());
+}
+
+TEST(BitReservoirTest, ThirtyTwoBitGenerators) {
+    pcg32 gen(1234567);
+    pcg32 reference(1234567);
+    bit_reservoir<pcg32> bits(gen);
+    for (std::size_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(random_word_64(reference), bits());
+    }
+}
+
+// A word and bits put back are handed out again in the same order
+TEST(BitReservoirTest, PutBackWord) {
+    pcg64 gen(1234567);
+    bit_reservoir<pcg64> bits(gen);
+    bits.bits(5);
+    auto [x, n] = bits.take_available();
+    std::uint64_t word = bits();
+    std::uint64_t consumed = bits.bits_consumed();
+
+    bits.put_back_word(word);
+    bits.put_back(x, n);
+    EXPECT_EQ(consumed - 64 - n, bits.bits_consumed());
+    EXPECT_EQ(x, bits.bits(n));
+    EXPECT_EQ(word, bits.bits(64));
+    EXPECT_EQ(consumed, bits.bits_consumed());
+}
+
+// The shuffle creates its own reservoir, one created by the caller gives the same result
+TEST(BitReservoirTest, SameShuffleWithOwnReservoir) {
+    std::vector<std::size_t> V(100000);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    pcg64 gen(1234567);
+    inplace_scatter_shuffle(std::span {V}, gen);
+
+    pcg64 other_gen(1234567);
+    bit_reservoir<pcg64> bits(other_gen);
+    inplace_scatter_shuffle(std::span {W}, bits);
+
+    EXPECT_EQ(V, W);
+}
+
+// A shuffle of n items needs at least log2(n!) random bits. Every level of the recursion costs 
+// LOG_NUM_BUCKETS bits per item for the rough scatter and little more for the multinomial. The 
+// Fisher-Yates of the leaves and stashes draws all indices of up to 18 items from one word, which 
+// is at most half a word per item here. In total that is strictly less than one word per item.
+TEST(BitReservoirTest, BitsPerItem) {
+    for (std::size_t size : {10, 1000, 100000}) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        pcg64 gen(1234567);
+        bit_reservoir<pcg64> bits(gen);
+        inplace_scatter_shuffle(std::span {V}, bits, cache_sizes {});
+
+        double bits_per_item = static_cast<double>(bits.bits_consumed()) / static_cast<double>(size);
+        double lower_bound = std::lgamma(static_cast<double>(size) + 1) / std::log(2.0) / static_cast<double>(size);
+        EXPECT_GE(bits_per_item, lower_bound) << size;
+        std::size_t levels = 0;
+        for (std::size_t n = size; n > THRESHOLD; n /= NUM_BUCKETS) {
+            levels++;
+        }
+        EXPECT_LT(bits_per_item, static_cast<double>(levels * LOG_NUM_BUCKETS + 32)) << size;
+        EXPECT_LT(bits_per_item, 64.0) << size;
+
+        std::sort(V.begin(), V.end());
+        for (std::size_t i = 0; i < size; i++) {
+            ASSERT_EQ(i, V[i]);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+// The independence test of chi_squared_test, all shuffles draw from one reservoir. With 
+// LOG_NUM_BUCKETS = 3 the bits rough_scatter hands back are used by the next level.
+TEST(BitReservoirTest, IndependenceTest) {
+    const std::size_t size = 40;
+    const double confidence = 0.05;
+    std::size_t sample_size = 1000 * size * size;
+
+    pcg64 generator(1234567);
+    bit_reservoir<pcg64> bits(generator);
+    independence_test(size, sample_size, confidence, [&](std::span<std::size_t> data_span) {
+        inplace_scatter_shuffle(data_span, bits, cache_sizes {});
+    });
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+#include "chi_squared_helpers.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// Built with ROUGH_SCATTER_KERNEL = 2 the levels which do not fit into the last cache use 
+// block_rough_scatter. Without L2 every level has NUM_BUCKETS, so with a last cache of 64 bytes 
+// every level with more than 8 items of 8 bytes uses it.
+static_assert(ROUGH_SCATTER_KERNEL == 2);
+const cache_sizes small_caches {0, 0, 64};
+
+class BlockScatterTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        std::uint64_t seed;
+
+        void SetUp() override {
+            seed = 20240702;
+        }
+};
+
+TEST_P(BlockScatterTestFixture, IsPermutation) {
+    const std::size_t size = GetParam();
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+
+    pcg64 gen(seed);
+    inplace_scatter_shuffle(std::span {V}, gen, small_caches);
+
+    std::sort(V.begin(), V.end());
+    for (std::size_t i = 0; i < size; i++) {
+        ASSERT_EQ(i, V[i]);
+    }
+}
+
+// Items without a default constructor cannot wait in the blocks, they use cycle_rough_scatter
+struct no_default {
+    explicit no_default(std::size_t value) : value(value) {}
+    std::size_t value;
+    bool operator==(const no_default &) const = default;
+};
+
+TEST_P(BlockScatterTestFixture, NotDefaultInitializable) {
+    const std::size_t size = GetParam();
+    std::vector<no_default> V;
+    for (std::size_t i = 0; i < size; i++) {
+        V.emplace_back(i);
+    }
+    std::vector<no_default> W = V;
+
+    pcg64 gen(seed);
+    inplace_scatter_shuffle(std::span {V}, gen, small_caches);
+    pcg64 cycle_gen(seed);
+    inplace_scatter_shuffle(std::span {W}, cycle_gen, cache_sizes {});
+
+    EXPECT_EQ(V, W);
+}
+
+INSTANTIATE_TEST_SUITE_P(BlockScatterTest,
+                         BlockScatterTestFixture,
+                         testing::Values(40, 1000, 100000));
+
+//-------------------------------------------------------------------------------------------------
+
+// The independence test of chi_squared_test, the root of 40 items uses block_rough_scatter
+TEST(BlockScatterTest, IndependenceTest) {
+    const std::size_t size = 40;
+    const double confidence = 0.05;
+    std::size_t sample_size = 1000 * size * size;
+
+    pcg64 generator(1234567);
+    independence_test(size, sample_size, confidence, [&](std::span<std::size_t> data_span) {
+        inplace_scatter_shuffle(data_span, generator, small_caches);
+    });
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include <chacha.hpp>
+
+//-------------------------------------------------------------------------------------------------
+
+// The key 00 01 ... 1f of RFC 7539
+chacha20::key_type rfc_key() {
+    chacha20::key_type key;
+    for (std::uint32_t i = 0; i < 8; i++) {
+        key[i] = (4*i) | ((4*i + 1) << 8) | ((4*i + 2) << 16) | ((4*i + 3) << 24);
+    }
+    return key;
+}
+
+template<typename RNG>
+std::array<std::uint64_t, 8> first_block(RNG gen) {
+    std::array<std::uint64_t, 8> block;
+    for (auto &word : block) {
+        word = gen();
+    }
+    return block;
+}
+
+// RFC 7539, section 2.3.2. Its 32-bit counter 1 and 96-bit nonce 00000009 0000004a 00000000 are 
+// our 64-bit counter 0x0900000000000001 and 64-bit nonce 0x4a000000.
+TEST(ChaChaTest, KnownAnswersRfc7539) {
+    std::array<std::uint64_t, 8> expected = {
+        0x15593bd1e4e7f110ULL, 0xc47120a31fdd0f50ULL, 0x0368c033c7f4d1c7ULL, 0x4e6cd4c39aaa2204ULL,
+        0x09aa9f07466482d2ULL, 0xa2028bd905d7c214ULL, 0xb94e16ded19c12b5ULL, 0x4e3c50a2e883d0cbULL
+    };
+    EXPECT_EQ(expected, first_block(chacha20(rfc_key(), 0x4a000000, 0x0900000000000001ULL)));
+}
+
+// The keystreams of the all zero key and nonce, the ChaCha12 one is the first test vector of the 
+// reference implementation
+TEST(ChaChaTest, KnownAnswersZeroKey) {
+    std::array<std::uint64_t, 8> expected_20 = {
+        0x903df1a0ade0b876ULL, 0x28bd8653e56a5d40ULL, 0x1aed8da0b819d2bdULL, 0xc70d778bccef36a8ULL,
+        0x8d4857517c5941daULL, 0x374ad8b83fe02477ULL, 0x1ca11815f4b8436aULL, 0x8665eeb269b687c3ULL
+    };
+    EXPECT_EQ(expected_20, first_block(chacha20()));
+
+    std::array<std::uint64_t, 8> expected_12 = {
+        0x53f955076a9af49bULL, 0xd583265f12ce1f81ULL, 0x1474e049bbc32904ULL, 0x5f15ae2ea589007eULL,
+        0xc0e37ad279f86405ULL, 0x798cfaac3428e82cULL, 0x1969dea02c9f623aULL, 0xbe2613412fe80b61ULL
+    };
+    EXPECT_EQ(expected_12, first_block(chacha12()));
+}
+
+// The AVX-512, AVX2 and scalar paths and mixtures of them give the same keystream
+TEST(ChaChaTest, LanesGiveSameKeystream) {
+    chacha<12, 1> scalar(rfc_key(), 7);
+    chacha<12, 8> avx2(rfc_key(), 7);
+    chacha<12, 16> avx512(rfc_key(), 7);
+    chacha<12, 29> mixed(rfc_key(), 7);
+    for (std::size_t i = 0; i < 1000; i++) {
+        std::uint64_t expected = scalar();
+        ASSERT_EQ(expected, avx2()) << i;
+        ASSERT_EQ(expected, avx512()) << i;
+        ASSERT_EQ(expected, mixed()) << i;
+    }
+}
+
+TEST(ChaChaTest, CounterSelectsBlock) {
+    chacha20 gen(rfc_key(), 3, 5);
+    for (std::size_t i = 0; i < 8; i++) {
+        gen();
+    }
+    EXPECT_EQ(first_block(chacha20(rfc_key(), 3, 6)), first_block(gen));
+}
+
+TEST(ChaChaTest, FillMatchesSingleCalls) {
+    chacha20 a(rfc_key());
+    chacha20 b(rfc_key());
+
+    std::vector<std::uint64_t> expected(1000);
+    for (auto &x : expected) {
+        x = a();
+    }
+
+    std::vector<std::uint64_t> filled(1000);
+    filled[0] = b();
+    b.fill(filled.data() + 1, 6);
+    b.fill(filled.data() + 7, filled.size() - 7);
+
+    EXPECT_EQ(expected, filled);
+}
+
+// The parallel shuffles only take the generators for which this is false, see seeded_generator
+static_assert(cryptographic_generator<chacha20> && cryptographic_generator<chacha12>);
+static_assert(!cryptographic_generator<std::mt19937_64>);
+
+TEST(ChaChaTest, ShufflesArePermutations) {
+    std::seed_seq seed_sequence {1, 2, 3, 4};
+    chacha20 gen(seed_sequence);
+    for (std::size_t size : {10, 1000, 100000}) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        inplace_scatter_shuffle(std::span {V}, gen);
+        std::sort(V.begin(), V.end());
+        for (std::size_t i = 0; i < size; i++) {
+            ASSERT_EQ(i, V[i]);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef CHI_SQUARED_HELPERS_HPP
+#define CHI_SQUARED_HELPERS_HPP
+
+#include <gtest/gtest.h>
+#include <boost/math/distributions/chi_squared.hpp>
+
+#include <numeric>
+#include <span>
+#include <vector>
+
+inline double calc_critical_value(int degree_of_freedom, double alpha) {
+    try {
+        boost::math::chi_squared distr(degree_of_freedom);
+        // This gives us the upper critical value to the distribution. In other words,
+        // it returns x such that P(X > x) == confidence.
+        double critical_value = quantile(complement(distr, alpha));
+        return critical_value;
+    } catch(const std::exception& e) {
+        std::cout << "\n""Message from thrown exception was:\n " << e.what() << "\n";
+        throw;
+    }
+}
+
+// Shuffles 0, ..., size - 1 sample_size times with shuffle and counts how often item i ends up at
+// position j. Every row is tested for independence at confidence / size as in chi_squared_test.
+// Returns the counts.
+template<typename Shuffle>
+std::vector<std::vector<std::size_t>> independence_test(std::size_t size, std::size_t sample_size, double confidence, Shuffle shuffle) {
+    std::vector<std::vector<std::size_t>> results(size, std::vector<std::size_t>(size));
+
+    for (std::size_t l = 0; l < sample_size; l++) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        std::span vector_span {V};
+        shuffle(vector_span);
+
+        for (std::size_t j = 0; j < size; j++) {
+            std::size_t i = vector_span[j];
+            results[i][j]++;
+        }
+    }
+
+    double critical_value = calc_critical_value(size - 1, confidence / static_cast<double>(size));
+    double expected_value = static_cast<double>(sample_size) / static_cast<double>(size);
+    for (size_t i = 0; i < size; i++) {
+        std::vector<size_t> observations = results[i];
+        double chi_squared_value = 0.0;
+        for (size_t j = 0; j < size; j++) {
+            chi_squared_value += std::pow(observations[j] - expected_value, 2) / expected_value;
+        }
+        bool reject = (chi_squared_value > critical_value) ? true : false;
+        EXPECT_EQ(false, reject) << i << " " << chi_squared_value << " " << critical_value;
+    }
+    return results;
+}
+
+#endif /* CHI_SQUARED_HELPERS_HPP */
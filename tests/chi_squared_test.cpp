@@ -1,21 +1,8 @@
 #include <gtest/gtest.h>
-#include <boost/math/distributions/chi_squared.hpp>
 
 #include <cip_shuffle.hpp>
 #include "pcg-cpp-0.98/include/pcg_random.hpp"
-
-double calc_critical_value(int degree_of_freedom, double alpha) {
-    try {
-        boost::math::chi_squared distr(degree_of_freedom);
-        // This gives us the upper critical value to the distribution. In other words, 
-        // it returns x such that P(X > x) == confidence. 
-        double critical_value = quantile(complement(distr, alpha));
-        return critical_value;
-    } catch(const std::exception& e) {
-        std::cout << "\n""Message from thrown exception was:\n " << e.what() << "\n";
-        throw;
-    }
-}
+#include "chi_squared_helpers.hpp"
 
 void my_print(std::vector<std::vector<std::size_t>> &matrix) {
     for (std::size_t i = 0; i < matrix.size(); i++) {
@@ -48,35 +35,14 @@ TEST_P(CipShuffleTestFixture, IndependenceTest) {
 
     std::size_t sample_size = 1000 * size * size;
     // std::size_t sample_size = 1;
-    std::vector<std::vector<std::size_t>> results(size, std::vector<std::size_t>(size));
-
-    for (std::size_t l = 0; l < sample_size; l++) {
-        std::vector<std::size_t> V(size);
-        std::iota(V.begin(), V.end(), 0);
-        std::span vector_span {V};
-        inplace_scatter_shuffle(vector_span, generator);
+    auto results = independence_test(size, sample_size, confidence, [&](std::span<std::size_t> vector_span) {
+        // NUM_BUCKETS on all levels, the same permutations on every machine
+        inplace_scatter_shuffle(vector_span, generator, cache_sizes {});
         // buffered_fisher_yates_shuffle_64(vector_span, generator);
         // fisher_yates_shuffle_64(vector_span, generator);
-
-        for (std::size_t j = 0; j < size; j++) {
-            std::size_t i = vector_span[j];
-            results[i][j]++;
-        }
-    }
+    });
 
     my_print(results);
-
-    double critical_value = calc_critical_value(size - 1, confidence / static_cast<double>(size));
-    double expected_value = static_cast<double>(sample_size) / static_cast<double>(size);
-    for (size_t i = 0; i < size; i++) {
-        std::vector<size_t> observations = results[i];
-        double chi_squared_value = 0.0;
-        for (size_t j = 0; j < size; j++) {
-            chi_squared_value += std::pow(observations[j] - expected_value, 2) / expected_value;
-        }
-        bool reject = (chi_squared_value > critical_value) ? true : false;
-        EXPECT_EQ(false, reject) << i << " " << chi_squared_value << " " << critical_value;
-    }
 }
 
 INSTANTIATE_TEST_SUITE_P(CipShuffleTest, 
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+class DeterministicShuffleTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        std::uint64_t seed;
+
+        void SetUp() override {
+            seed = 20231213;
+        }
+};
+
+TEST_P(DeterministicShuffleTestFixture, IndependentOfThreadCount) {
+    const std::size_t size = GetParam();
+
+    std::vector<std::size_t> reference(size);
+    std::iota(reference.begin(), reference.end(), 0);
+    deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {reference}, seed, 1);
+
+    for (std::size_t num_threads : {2, 3, 4, 8}) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {V}, seed, num_threads);
+
+        EXPECT_EQ(reference, V) << num_threads << " threads";
+    }
+}
+
+TEST_P(DeterministicShuffleTestFixture, IsPermutation) {
+    const std::size_t size = GetParam();
+
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {V}, seed, 4);
+
+    std::sort(V.begin(), V.end());
+    for (std::size_t i = 0; i < size; i++) {
+        ASSERT_EQ(i, V[i]);
+    }
+}
+
+TEST_P(DeterministicShuffleTestFixture, DependsOnSeed) {
+    const std::size_t size = GetParam();
+
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+    deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {V}, seed, 4);
+    deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {W}, seed + 1, 4);
+
+    EXPECT_NE(V, W);
+}
+
+INSTANTIATE_TEST_SUITE_P(DeterministicShuffleTest,
+                         DeterministicShuffleTestFixture,
+                         testing::Values(10, 100, 1000, 10000, 100000));
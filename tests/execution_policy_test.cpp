@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle_execution.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// unseq came with C++20
+#if defined(__cpp_lib_execution) && __cpp_lib_execution >= 201902L
+
+class ExecutionPolicyTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        std::uint64_t seed;
+
+        void SetUp() override {
+            seed = 20240620;
+        }
+};
+
+template<typename ExecutionPolicy>
+void expect_permutation(ExecutionPolicy &&policy, std::size_t size, std::uint64_t seed) {
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    pcg64 gen(seed);
+    inplace_scatter_shuffle(policy, std::span {V}, gen);
+
+    std::sort(V.begin(), V.end());
+    for (std::size_t i = 0; i < size; i++) {
+        ASSERT_EQ(i, V[i]);
+    }
+}
+
+TEST_P(ExecutionPolicyTestFixture, Seq) {
+    expect_permutation(std::execution::seq, GetParam(), seed);
+}
+
+TEST_P(ExecutionPolicyTestFixture, Unseq) {
+    expect_permutation(std::execution::unseq, GetParam(), seed);
+}
+
+TEST_P(ExecutionPolicyTestFixture, Par) {
+    expect_permutation(std::execution::par, GetParam(), seed);
+}
+
+TEST_P(ExecutionPolicyTestFixture, ParUnseq) {
+    expect_permutation(std::execution::par_unseq, GetParam(), seed);
+}
+
+// seq and unseq are the sequential shuffle
+TEST_P(ExecutionPolicyTestFixture, SeqIsSequential) {
+    const std::size_t size = GetParam();
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+    std::vector<std::size_t> U = V;
+
+    pcg64 gen(seed);
+    inplace_scatter_shuffle(std::span {V}, gen);
+    pcg64 seq_gen(seed);
+    inplace_scatter_shuffle(std::execution::seq, std::span {W}, seq_gen);
+    pcg64 unseq_gen(seed);
+    inplace_scatter_shuffle(std::execution::unseq, std::span {U}, unseq_gen);
+
+    EXPECT_EQ(V, W);
+    EXPECT_EQ(V, U);
+}
+
+INSTANTIATE_TEST_SUITE_P(ExecutionPolicyTest,
+                         ExecutionPolicyTestFixture,
+                         testing::Values(10, 1000, 100000));
+
+#endif
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+#include "chi_squared_helpers.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// Every row is tested at 0.05 / size as in chi_squared_test. The sequential tests use its 
+// 1000 * size^2 samples. parallel_merge_shuffle starts its threads in every call, hence it gets 
+// 100 * size^2 samples.
+class MergeShuffleTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        int seed;
+        double confidence;
+
+        void SetUp() override {
+            seed = 1234567;
+            confidence = 0.05;
+        }
+};
+
+TEST_P(MergeShuffleTestFixture, IndependenceTest) {
+    pcg64 generator(seed);
+    const std::size_t size = GetParam();
+
+    independence_test(size, 1000 * size * size, confidence, [&](std::span<std::size_t> data_span) {
+        merge_shuffle(data_span, generator);
+    });
+}
+
+// A single merge of two blocks which are shuffled with Fisher-Yates
+TEST_P(MergeShuffleTestFixture, MergeIndependenceTest) {
+    pcg64 generator(seed);
+    const std::size_t size = GetParam();
+
+    independence_test(size, 1000 * size * size, confidence, [&](std::span<std::size_t> data_span) {
+        const std::size_t mid = size / 3;
+        fisher_yates_shuffle(data_span.first(mid), generator);
+        fisher_yates_shuffle(data_span.subspan(mid), generator);
+        merge_shuffled_blocks(data_span, mid, generator);
+    });
+}
+
+TEST_P(MergeShuffleTestFixture, ParallelIndependenceTest) {
+    pcg64 generator(seed);
+    const std::size_t size = GetParam();
+
+    independence_test(size, 100 * size * size, confidence, [&](std::span<std::size_t> data_span) {
+        parallel_merge_shuffle(data_span, generator, 3);
+    });
+}
+
+INSTANTIATE_TEST_SUITE_P(MergeShuffleTest,
+                         MergeShuffleTestFixture,
+                         testing::Values(10, 33, 64));
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+TEST(NumaTest, ParseCpuList) {
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), parse_cpu_list("0-3"));
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), parse_cpu_list("0-3,8,10-11"));
+    EXPECT_EQ(std::vector<int>({4, 5, 7}), parse_cpu_list("4-5,7\n"));
+    EXPECT_EQ(std::vector<int>({0}), parse_cpu_list("0\n"));
+    EXPECT_EQ(std::vector<int>({}), parse_cpu_list(""));
+    EXPECT_EQ(std::vector<int>({}), parse_cpu_list("\n"));
+}
+
+TEST(NumaTest, NodeOfCpu) {
+    numa_topology topology;
+    topology.node_ids = {0, 2};
+    topology.node_cpus = {{0, 1}, {2, 3}};
+    EXPECT_EQ(0, topology.node_of_cpu(1));
+    EXPECT_EQ(1, topology.node_of_cpu(2));
+    EXPECT_EQ(-1, topology.node_of_cpu(4));
+    EXPECT_EQ(-1, topology.majority_node(nullptr, 0));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+class NumaShuffleTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        std::uint64_t seed;
+
+        void SetUp() override {
+            seed = 20240618;
+        }
+};
+
+// The permutation is the same as with the plain parallel shuffle
+TEST_P(NumaShuffleTestFixture, SameAsParallelShuffle) {
+    const std::size_t size = GetParam();
+
+    std::vector<std::size_t> reference(size);
+    std::iota(reference.begin(), reference.end(), 0);
+    pcg64 gen(seed);
+    work_stealing_scheduler scheduler(4);
+    parallel_inplace_scatter_shuffle(std::span {reference}, gen, scheduler);
+
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    pcg64 numa_gen(seed);
+    numa_parallel_inplace_scatter_shuffle(std::span {V}, numa_gen, 4);
+    EXPECT_EQ(reference, V);
+
+    std::sort(V.begin(), V.end());
+    for (std::size_t i = 0; i < size; i++) {
+        ASSERT_EQ(i, V[i]);
+    }
+}
+
+// A single node: nothing is placed on a node and the result is the same for any number of threads
+TEST_P(NumaShuffleTestFixture, SingleNode) {
+    const std::size_t size = GetParam();
+    numa_topology topology;
+    topology.node_ids = {0};
+    topology.node_cpus = {{0}};
+
+    std::vector<std::size_t> reference(size);
+    std::iota(reference.begin(), reference.end(), 0);
+    deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {reference}, seed, 1);
+
+    for (std::size_t num_threads : {1, 2, 4}) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        work_stealing_scheduler scheduler(num_threads, topology);
+        deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {V}, seed, scheduler);
+        EXPECT_EQ(reference, V) << num_threads << " threads";
+
+        numa_placement_stats stats = scheduler.placement_stats();
+        EXPECT_EQ(0, stats.local_tasks + stats.remote_tasks);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(NumaShuffleTest,
+                         NumaShuffleTestFixture,
+                         testing::Values(10, 1000, 100000));
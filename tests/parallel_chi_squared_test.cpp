@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+#include "chi_squared_helpers.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// With PARALLEL_THRESHOLD = 8 the root of 40 items scatters in 5 stripes and of 64 items in 8 
+// stripes. Its buckets have more than 8 items, so they are spawned as tasks as well.
+constexpr std::array<std::size_t, 2> SIZES = {40, 64};
+
+class ParallelShuffleTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        int seed;
+        double confidence;
+        std::size_t num_threads;
+
+        void SetUp() override {
+            seed = 1234567;
+            confidence = 0.05;
+            num_threads = 4;
+        }
+};
+
+TEST_P(ParallelShuffleTestFixture, IndependenceTest) {
+    pcg64 generator(seed);
+
+    const std::size_t size = GetParam();
+
+    // The sample size of chi_squared_test
+    std::size_t sample_size = 1000 * size * size;
+
+    work_stealing_scheduler scheduler(num_threads);
+    independence_test(size, sample_size, confidence, [&](std::span<std::size_t> data_span) {
+        parallel_inplace_scatter_shuffle(data_span, generator, scheduler);
+    });
+}
+
+INSTANTIATE_TEST_SUITE_P(ParallelShuffleTest,
+                         ParallelShuffleTestFixture,
+                         testing::ValuesIn(SIZES));
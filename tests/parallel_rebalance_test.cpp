@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// The waves of plan_rebalance have to leave the same bucket limits and the same placed items
+// behind as rebalance_buckets with the same generator. Only the staged items may end up in other
+// stashes. The pieces of a wave may run in any order, so they are applied in a random one.
+class ParallelRebalanceTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        std::uint64_t seed;
+
+        void SetUp() override {
+            seed = 20240612;
+        }
+};
+
+// Random limits of K buckets with size items in total. The placed items of bucket i are
+// i * size + j, the staged ones K * size + j.
+template<std::size_t K>
+void random_buckets(std::size_t size, pcg64 &gen, std::vector<std::size_t> &V, std::array<bucket_limits, K> &buckets) {
+    std::array<std::size_t, K + 1> bounds {};
+    for (std::size_t i = 1; i < K; i++) {
+        bounds[i] = std::uniform_int_distribution<std::size_t>(0, size)(gen);
+    }
+    bounds[K] = size;
+    std::sort(bounds.begin(), bounds.end());
+
+    V.resize(size);
+    for (std::size_t i = 0; i < K; i++) {
+        buckets[i].begin = bounds[i];
+        buckets[i].staged = std::uniform_int_distribution<std::size_t>(bounds[i], bounds[i+1])(gen);
+        buckets[i].end = bounds[i+1];
+        for (std::size_t j = buckets[i].begin; j < buckets[i].staged; j++) {
+            V[j] = i * size + j;
+        }
+        for (std::size_t j = buckets[i].staged; j < buckets[i].end; j++) {
+            V[j] = K * size + j;
+        }
+    }
+}
+
+template<typename T>
+std::vector<T> sorted(std::span<T> data_span) {
+    std::vector<T> items(data_span.begin(), data_span.end());
+    std::sort(items.begin(), items.end());
+    return items;
+}
+
+template<std::size_t K>
+void expect_same_as_rebalance_buckets(std::size_t size, std::size_t piece_size, std::uint64_t seed) {
+    pcg64 gen(seed);
+    std::vector<std::size_t> V;
+    std::array<bucket_limits, K> buckets;
+    random_buckets(size, gen, V, buckets);
+    std::vector<std::size_t> W = V;
+    std::array<bucket_limits, K> parallel_buckets = buckets;
+
+    pcg64 rebalance_gen(seed);
+    rebalance_buckets(std::span {V}, buckets, rebalance_gen);
+
+    pcg64 parallel_gen(seed);
+    auto final_bucket_sizes = draw_final_bucket_sizes(parallel_buckets, parallel_gen);
+    for (auto &wave : plan_rebalance(parallel_buckets, final_bucket_sizes)) {
+        std::vector<range_swap> pieces = split_range_swaps(wave, piece_size);
+        for (const range_swap &piece : pieces) {
+            ASSERT_LE(piece.length, piece_size);
+        }
+        // The ranges of a wave are disjoint
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        for (const range_swap &piece : pieces) {
+            ranges.push_back({piece.first, piece.first + piece.length});
+            ranges.push_back({piece.second, piece.second + piece.length});
+        }
+        std::sort(ranges.begin(), ranges.end());
+        for (std::size_t j = 1; j < ranges.size(); j++) {
+            ASSERT_LE(ranges[j-1].second, ranges[j].first);
+        }
+
+        std::shuffle(pieces.begin(), pieces.end(), gen);
+        for (const range_swap &piece : pieces) {
+            swap_ranges(std::span {W}, piece);
+        }
+    }
+    EXPECT_EQ(rebalance_gen(), parallel_gen());
+
+    for (std::size_t i = 0; i < K; i++) {
+        ASSERT_EQ(buckets[i].begin, parallel_buckets[i].begin) << i;
+        ASSERT_EQ(buckets[i].staged, parallel_buckets[i].staged) << i;
+        ASSERT_EQ(buckets[i].end, parallel_buckets[i].end) << i;
+        std::span placed = std::span {V}.subspan(buckets[i].begin, buckets[i].num_placed());
+        std::span parallel_placed = std::span {W}.subspan(buckets[i].begin, buckets[i].num_placed());
+        EXPECT_EQ(sorted(placed), sorted(parallel_placed)) << i;
+    }
+    EXPECT_EQ(sorted(std::span {V}), sorted(std::span {W}));
+}
+
+// One piece per swap
+TEST_P(ParallelRebalanceTestFixture, TwoBuckets) {
+    for (std::size_t l = 0; l < 100; l++) {
+        expect_same_as_rebalance_buckets<2>(GetParam(), REBALANCE_PIECE_SIZE, seed + l);
+    }
+}
+
+TEST_P(ParallelRebalanceTestFixture, NumBuckets) {
+    for (std::size_t l = 0; l < 100; l++) {
+        expect_same_as_rebalance_buckets<NUM_BUCKETS>(GetParam(), REBALANCE_PIECE_SIZE, seed + l);
+    }
+}
+
+// Waves with many pieces
+TEST_P(ParallelRebalanceTestFixture, TinyPieces) {
+    for (std::size_t piece_size : {1, 3}) {
+        for (std::size_t l = 0; l < 100; l++) {
+            expect_same_as_rebalance_buckets<2>(GetParam(), piece_size, seed + l);
+            expect_same_as_rebalance_buckets<NUM_BUCKETS>(GetParam(), piece_size, seed + l);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(ParallelRebalanceTests, ParallelRebalanceTestFixture, testing::Values(0, 1, 10, 100, 1000, 10000));
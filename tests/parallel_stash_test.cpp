@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+#include "chi_squared_helpers.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// Built with PARALLEL_THRESHOLD = 4 the stashes of the inner nodes are larger than
+// PARALLEL_THRESHOLD, hence shuffle_node_stash shuffles them with a subtree of tasks.
+static_assert(PARALLEL_THRESHOLD == 4 && NUM_BUCKETS == 4);
+
+class ParallelStashTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        std::uint64_t seed;
+
+        void SetUp() override {
+            seed = 20240615;
+        }
+};
+
+// The stash of a node of this size takes the parallel path: it is larger than PARALLEL_THRESHOLD
+// and fits into the last bucket.
+TEST_P(ParallelStashTestFixture, StashAboveThreshold) {
+    const std::size_t size = GetParam();
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+
+    std::array<bucket_limits, NUM_BUCKETS> buckets;
+    init_buckets(size, buckets);
+    pcg64 gen(seed);
+    cycle_rough_scatter(std::span {V}, buckets, gen);
+    auto final_bucket_sizes = draw_final_bucket_sizes(buckets, gen);
+    plan_rebalance(buckets, final_bucket_sizes);
+
+    std::size_t stash_size = 0;
+    for (auto &bucket : buckets) {
+        stash_size += bucket.num_staged();
+    }
+    EXPECT_GT(stash_size, PARALLEL_THRESHOLD);
+    EXPECT_LE(stash_size, buckets[NUM_BUCKETS - 1].num_total());
+}
+
+TEST_P(ParallelStashTestFixture, IndependentOfThreadCount) {
+    const std::size_t size = GetParam();
+
+    std::vector<std::size_t> reference(size);
+    std::iota(reference.begin(), reference.end(), 0);
+    deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {reference}, seed, 1);
+
+    for (std::size_t num_threads : {2, 3, 4, 8}) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {V}, seed, num_threads);
+
+        EXPECT_EQ(reference, V) << num_threads << " threads";
+    }
+}
+
+TEST_P(ParallelStashTestFixture, IsPermutation) {
+    const std::size_t size = GetParam();
+
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    deterministic_parallel_inplace_scatter_shuffle<pcg64>(std::span {V}, seed, 4);
+
+    std::sort(V.begin(), V.end());
+    for (std::size_t i = 0; i < size; i++) {
+        ASSERT_EQ(i, V[i]);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(ParallelStashTest,
+                         ParallelStashTestFixture,
+                         testing::Values(40, 100, 1000, 10000, 100000));
+
+//-------------------------------------------------------------------------------------------------
+
+// The independence test of parallel_chi_squared_test. Already the root of 40 items has a stash
+// with more than PARALLEL_THRESHOLD items, see StashAboveThreshold.
+TEST(ParallelStashTest, IndependenceTest) {
+    const std::size_t size = 40;
+    const double confidence = 0.05;
+    std::size_t sample_size = 1000 * size * size;
+
+    pcg64 generator(1234567);
+    work_stealing_scheduler scheduler(4);
+    independence_test(size, sample_size, confidence, [&](std::span<std::size_t> data_span) {
+        parallel_inplace_scatter_shuffle(data_span, generator, scheduler);
+    });
+}
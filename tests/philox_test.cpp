@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include <philox.hpp>
+
+//-------------------------------------------------------------------------------------------------
+
+// Known answers of the reference implementation (Random123, kat_vectors)
+TEST(PhiloxTest, KnownAnswers) {
+    philox4x64::counter_type zero = philox4x64::block({0, 0, 0, 0}, {0, 0});
+    philox4x64::counter_type expected_zero = {0x16554d9eca36314cULL, 0xdb20fe9d672d0fdcULL, 0xd7e772cee186176bULL, 0x7e68b68aec7ba23bULL};
+    EXPECT_EQ(expected_zero, zero);
+
+    const std::uint64_t ones = ~std::uint64_t(0);
+    philox4x64::counter_type all_ones = philox4x64::block({ones, ones, ones, ones}, {ones, ones});
+    philox4x64::counter_type expected_all_ones = {0x87b092c3013fe90bULL, 0x438c3c67be8d0224ULL, 0x9cc7d7c69cd777b6ULL, 0xa09caebf594f0ba0ULL};
+    EXPECT_EQ(expected_all_ones, all_ones);
+}
+
+TEST(PhiloxTest, DiscardMatchesStepping) {
+    for (unsigned long long z : {0ULL, 1ULL, 3ULL, 4ULL, 5ULL, 17ULL, 1000ULL}) {
+        for (std::size_t start : {0, 1, 2, 3, 4, 7}) {
+            philox4x64 stepped(12345, 6);
+            philox4x64 skipped(12345, 6);
+            for (std::size_t i = 0; i < start; i++) {
+                stepped();
+                skipped();
+            }
+            for (unsigned long long i = 0; i < z; i++) {
+                stepped();
+            }
+            skipped.discard(z);
+            EXPECT_EQ(stepped(), skipped()) << z << " " << start;
+            EXPECT_EQ(stepped(), skipped()) << z << " " << start;
+        }
+    }
+}
+
+TEST(PhiloxTest, FillMatchesSingleCalls) {
+    philox4x64 a(99);
+    philox4x64 b(99);
+
+    std::vector<std::uint64_t> expected(300);
+    for (auto &x : expected) {
+        x = a();
+    }
+
+    std::vector<std::uint64_t> filled(300);
+    b();
+    filled[0] = expected[0];
+    b.fill(filled.data() + 1, 6);
+    b.fill(filled.data() + 7, filled.size() - 7);
+
+    EXPECT_EQ(expected, filled);
+}
+
+TEST(PhiloxTest, StreamsDiffer) {
+    philox4x64 gen(2024);
+    philox4x64 a = gen.substream(1);
+    philox4x64 b = gen.substream(2);
+    EXPECT_NE(a(), b());
+    EXPECT_EQ(philox4x64(2024, 1)(), gen.substream(1)());
+}
+
+TEST(PhiloxTest, ShufflesArePermutations) {
+    auto gen = seeded_generator<philox4x64>(20240101);
+    for (std::size_t size : {10, 1000, 100000}) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        inplace_scatter_shuffle(std::span {V}, gen);
+        std::sort(V.begin(), V.end());
+        for (std::size_t i = 0; i < size; i++) {
+            ASSERT_EQ(i, V[i]);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+#include "chi_squared_helpers.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+static_assert(random_generator_64<pcg64>);
+static_assert(random_generator_64<std::mt19937_64>);
+static_assert(random_generator_32<pcg32>);
+static_assert(random_generator_32<std::mt19937>);
+static_assert(random_generator_64<rng_adapter<std::mt19937>>);
+static_assert(random_generator_64<rng_adapter<std::minstd_rand>>);
+
+static_assert(generator_bits<pcg64>() == 64);
+static_assert(generator_bits<pcg32>() == 32);
+static_assert(generator_bits<std::minstd_rand>() == 30);
+static_assert(random_word_bits<pcg32> == 32);
+static_assert(random_word_bits<std::minstd_rand> == 64);
+
+TEST(RngAdapterTest, ConcatenatesWords) {
+    std::mt19937 gen(1234567);
+    std::mt19937 reference(1234567);
+    rng_adapter<std::mt19937> adapter(gen);
+    for (std::size_t i = 0; i < 100; i++) {
+        std::uint64_t high = reference();
+        std::uint64_t low = reference();
+        EXPECT_EQ((high << 32) | low, adapter());
+    }
+    // 32-bit generators need a single word for 32 bits
+    EXPECT_EQ(reference(), adapter.next_32());
+}
+
+TEST(RngAdapterTest, SixtyFourBitGeneratorsAreUnchanged) {
+    pcg64 gen(1234567);
+    pcg64 reference(1234567);
+    for (std::size_t i = 0; i < 100; i++) {
+        EXPECT_EQ(reference(), random_word_64(gen));
+    }
+}
+
+// Every bit of the 64-bit words of a generator with 30 bits per word has to be set half the time
+TEST(RngAdapterTest, AllBitsUniform) {
+    std::minstd_rand gen(1234567);
+    rng_adapter<std::minstd_rand> adapter(gen);
+
+    const std::size_t sample_size = 100000;
+    std::array<std::size_t, 64> ones {};
+    for (std::size_t l = 0; l < sample_size; l++) {
+        std::uint64_t x = adapter();
+        for (std::size_t b = 0; b < 64; b++) {
+            ones[b] += (x >> b) & 1;
+        }
+    }
+    // At most 6 standard deviations away from n / 2
+    const double expected = sample_size / 2.0;
+    const double max_deviation = 6 * std::sqrt(sample_size / 4.0);
+    for (std::size_t b = 0; b < 64; b++) {
+        EXPECT_NEAR(expected, static_cast<double>(ones[b]), max_deviation) << "bit " << b;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+// The independence test of chi_squared_test with generators which are not 64-bit
+template<typename RNG>
+void shuffle_independence_test(std::size_t size, RNG &generator) {
+    const double confidence = 0.05;
+    std::size_t sample_size = 1000 * size * size;
+    independence_test(size, sample_size, confidence, [&](std::span<std::size_t> data_span) {
+        inplace_scatter_shuffle(data_span, generator, cache_sizes {});
+    });
+}
+
+TEST(RngAdapterTest, IndependenceTest32) {
+    pcg32 generator(1234567);
+    shuffle_independence_test(40, generator);
+}
+
+TEST(RngAdapterTest, IndependenceTestMinstd) {
+    std::minstd_rand generator(1234567);
+    shuffle_independence_test(40, generator);
+}
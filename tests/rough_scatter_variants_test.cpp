@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+static_assert(ROUGH_SCATTER_KERNEL == 1);
+
+// The variants of rough_scatter have to do the same swaps as rough_scatter with the same
+// generator, i.e. leave the same items and buckets behind.
+class RoughScatterVariantsTestFixture : public testing::TestWithParam<std::size_t> {
+    protected:
+        std::uint64_t seed;
+
+        void SetUp() override {
+            seed = 20240521;
+        }
+};
+
+template<typename F>
+void expect_same_as_rough_scatter(std::size_t size, std::uint64_t seed, F variant) {
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    std::array<bucket_limits, NUM_BUCKETS> buckets;
+    init_buckets(size, buckets);
+    std::array<bucket_limits, NUM_BUCKETS> variant_buckets = buckets;
+
+    pcg64 gen(seed);
+    rough_scatter(std::span {V}, buckets, gen);
+    pcg64 variant_gen(seed);
+    variant(std::span {W}, variant_buckets, variant_gen);
+
+    EXPECT_EQ(V, W);
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        EXPECT_EQ(buckets[i].begin, variant_buckets[i].begin) << i;
+        EXPECT_EQ(buckets[i].staged, variant_buckets[i].staged) << i;
+        EXPECT_EQ(buckets[i].end, variant_buckets[i].end) << i;
+    }
+}
+
+TEST_P(RoughScatterVariantsTestFixture, Prefetching) {
+    expect_same_as_rough_scatter(GetParam(), seed, [](std::span<std::size_t> data_span, std::array<bucket_limits, NUM_BUCKETS> &buckets, pcg64 &gen) {
+        prefetching_rough_scatter(data_span, buckets, gen);
+    });
+}
+
+TEST_P(RoughScatterVariantsTestFixture, Cycle) {
+    expect_same_as_rough_scatter(GetParam(), seed, [](std::span<std::size_t> data_span, std::array<bucket_limits, NUM_BUCKETS> &buckets, pcg64 &gen) {
+        cycle_rough_scatter(data_span, buckets, gen);
+    });
+}
+
+// The bits which are left go back into the reservoir as with rough_scatter
+TEST_P(RoughScatterVariantsTestFixture, PrefetchingWithReservoir) {
+    const std::size_t size = GetParam();
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    std::array<bucket_limits, NUM_BUCKETS> buckets;
+    init_buckets(size, buckets);
+    std::array<bucket_limits, NUM_BUCKETS> variant_buckets = buckets;
+
+    pcg64 gen(seed);
+    bit_reservoir<pcg64> bits(gen);
+    rough_scatter(std::span {V}, buckets, bits);
+    pcg64 variant_gen(seed);
+    bit_reservoir<pcg64> variant_bits(variant_gen);
+    prefetching_rough_scatter(std::span {W}, variant_buckets, variant_bits);
+
+    EXPECT_EQ(V, W);
+    EXPECT_EQ(bits.bits_consumed(), variant_bits.bits_consumed());
+    EXPECT_EQ(bits(), variant_bits());
+}
+
+TEST_P(RoughScatterVariantsTestFixture, CycleWithReservoir) {
+    const std::size_t size = GetParam();
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    std::array<bucket_limits, NUM_BUCKETS> buckets;
+    init_buckets(size, buckets);
+    std::array<bucket_limits, NUM_BUCKETS> variant_buckets = buckets;
+
+    pcg64 gen(seed);
+    bit_reservoir<pcg64> bits(gen);
+    rough_scatter(std::span {V}, buckets, bits);
+    pcg64 variant_gen(seed);
+    bit_reservoir<pcg64> variant_bits(variant_gen);
+    cycle_rough_scatter(std::span {W}, variant_buckets, variant_bits);
+
+    EXPECT_EQ(V, W);
+    EXPECT_EQ(bits.bits_consumed(), variant_bits.bits_consumed());
+    EXPECT_EQ(bits(), variant_bits());
+}
+
+// block_rough_scatter assigns the items to the same buckets but puts them in another order. The 
+// buckets and the bits used are the same as with rough_scatter and the items are a permutation.
+template<std::size_t B>
+void expect_block_like_rough_scatter(std::size_t size, std::uint64_t seed) {
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    std::array<bucket_limits, NUM_BUCKETS> buckets;
+    init_buckets(size, buckets);
+    std::array<bucket_limits, NUM_BUCKETS> variant_buckets = buckets;
+
+    pcg64 gen(seed);
+    bit_reservoir<pcg64> bits(gen);
+    rough_scatter(std::span {V}, buckets, bits);
+    pcg64 variant_gen(seed);
+    bit_reservoir<pcg64> variant_bits(variant_gen);
+    block_rough_scatter<NUM_BUCKETS, std::size_t, bit_reservoir<pcg64>, B>(std::span {W}, variant_buckets, variant_bits);
+
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        EXPECT_EQ(buckets[i].begin, variant_buckets[i].begin) << i;
+        EXPECT_EQ(buckets[i].staged, variant_buckets[i].staged) << i;
+        EXPECT_EQ(buckets[i].end, variant_buckets[i].end) << i;
+    }
+    EXPECT_EQ(bits.bits_consumed(), variant_bits.bits_consumed());
+    EXPECT_EQ(bits(), variant_bits());
+
+    std::sort(W.begin(), W.end());
+    for (std::size_t i = 0; i < size; i++) {
+        ASSERT_EQ(i, W[i]);
+    }
+}
+
+TEST_P(RoughScatterVariantsTestFixture, Block) {
+    expect_block_like_rough_scatter<SCATTER_BLOCK_SIZE>(GetParam(), seed);
+}
+
+// Blocks of single items and blocks larger than most buckets of the small sizes
+TEST_P(RoughScatterVariantsTestFixture, BlockSizes) {
+    expect_block_like_rough_scatter<1>(GetParam(), seed);
+    expect_block_like_rough_scatter<3>(GetParam(), seed);
+    expect_block_like_rough_scatter<64>(GetParam(), seed);
+}
+
+// Buckets with 32-bit positions give the same swaps
+TEST_P(RoughScatterVariantsTestFixture, ThirtyTwoBitBuckets) {
+    const std::size_t size = GetParam();
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    std::array<bucket_limits, NUM_BUCKETS> buckets;
+    init_buckets(size, buckets);
+    std::array<basic_bucket_limits<std::uint32_t>, NUM_BUCKETS> small_buckets;
+    init_buckets(size, small_buckets);
+
+    pcg64 gen(seed);
+    cycle_rough_scatter(std::span {V}, buckets, gen);
+    pcg64 small_gen(seed);
+    cycle_rough_scatter(std::span {W}, small_buckets, small_gen);
+
+    EXPECT_EQ(V, W);
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        EXPECT_EQ(buckets[i].begin, small_buckets[i].begin) << i;
+        EXPECT_EQ(buckets[i].staged, small_buckets[i].staged) << i;
+        EXPECT_EQ(buckets[i].end, small_buckets[i].end) << i;
+    }
+}
+
+// Built with ROUGH_SCATTER_KERNEL = 1 the levels which do not fit into the last cache use 
+// prefetching_rough_scatter, this does not change the permutation. Without L2 every level has 
+// NUM_BUCKETS.
+TEST_P(RoughScatterVariantsTestFixture, PrefetchingLevels) {
+    const std::size_t size = GetParam();
+    std::vector<std::size_t> V(size);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+
+    pcg64 gen(seed);
+    inplace_scatter_shuffle(std::span {V}, gen, cache_sizes {});
+    pcg64 prefetching_gen(seed);
+    inplace_scatter_shuffle(std::span {W}, prefetching_gen, cache_sizes {0, 0, 1024});
+
+    EXPECT_EQ(V, W);
+}
+
+INSTANTIATE_TEST_SUITE_P(RoughScatterVariantsTest,
+                         RoughScatterVariantsTestFixture,
+                         testing::Values(NUM_BUCKETS, 1000, 1 << 16, 1000003));
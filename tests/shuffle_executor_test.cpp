@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+// Executors with the same seed give the same permutations for any number of threads. The sizes
+// are below and above PARALLEL_THRESHOLD.
+constexpr std::array<std::size_t, 6> SIZES = {10, 32, 100, 1000, 10000, 100000};
+
+void expect_permutation(std::vector<std::size_t> V) {
+    std::sort(V.begin(), V.end());
+    for (std::size_t i = 0; i < V.size(); i++) {
+        ASSERT_EQ(i, V[i]);
+    }
+}
+
+// All results of shuffle() for SIZES, each size shuffled twice in a row
+std::vector<std::vector<std::size_t>> repeated_shuffles(std::size_t num_threads, std::uint64_t seed) {
+    shuffle_executor<pcg64> executor(num_threads, seed);
+    std::vector<std::vector<std::size_t>> results;
+    for (std::size_t size : SIZES) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        for (std::size_t l = 0; l < 2; l++) {
+            executor.shuffle(std::span {V});
+            results.push_back(V);
+        }
+    }
+    return results;
+}
+
+// All spans of SIZES in one call of shuffle_many, twice in a row
+std::vector<std::vector<std::size_t>> shuffle_many(std::size_t num_threads, std::uint64_t seed) {
+    shuffle_executor<pcg64> executor(num_threads, seed);
+    std::vector<std::vector<std::size_t>> results;
+    for (std::size_t size : SIZES) {
+        results.emplace_back(size);
+        std::iota(results.back().begin(), results.back().end(), 0);
+    }
+    std::vector<std::span<std::size_t>> spans(results.begin(), results.end());
+    executor.shuffle_many(spans);
+    std::vector<std::vector<std::size_t>> first = results;
+    executor.shuffle_many(spans);
+    results.insert(results.end(), first.begin(), first.end());
+    return results;
+}
+
+TEST(ShuffleExecutorTest, RepeatedShufflesIndependentOfThreadCount) {
+    const auto reference = repeated_shuffles(1, 20240601);
+    for (const auto &V : reference) {
+        expect_permutation(V);
+    }
+    for (std::size_t num_threads : {2, 3, 8}) {
+        EXPECT_EQ(reference, repeated_shuffles(num_threads, 20240601)) << num_threads << " threads";
+    }
+    EXPECT_NE(reference, repeated_shuffles(2, 20240602));
+}
+
+TEST(ShuffleExecutorTest, ShuffleManyIndependentOfThreadCount) {
+    const auto reference = shuffle_many(1, 20240601);
+    for (const auto &V : reference) {
+        expect_permutation(V);
+    }
+    for (std::size_t num_threads : {2, 3, 8}) {
+        EXPECT_EQ(reference, shuffle_many(num_threads, 20240601)) << num_threads << " threads";
+    }
+    EXPECT_NE(reference, shuffle_many(2, 20240602));
+}
+
+// Two calls of one executor give different permutations
+TEST(ShuffleExecutorTest, CallsDiffer) {
+    shuffle_executor<pcg64> executor(4, 20240601);
+    std::vector<std::size_t> V(100000);
+    std::iota(V.begin(), V.end(), 0);
+    std::vector<std::size_t> W = V;
+    executor.shuffle(std::span {V});
+    executor.shuffle(std::span {W});
+    EXPECT_NE(V, W);
+}
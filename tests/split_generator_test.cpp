@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <unordered_set>
+
+#include <cip_shuffle.hpp>
+#include <philox.hpp>
+#include "pcg-cpp-0.98/include/pcg_random.hpp"
+
+//-------------------------------------------------------------------------------------------------
+
+static_assert(stream_selectable_generator<pcg64>);
+static_assert(stream_selectable_generator<pcg32>);
+static_assert(stream_selectable_generator<philox4x64>);
+static_assert(!stream_selectable_generator<pcg64_fast>);
+static_assert(advanceable_generator<pcg64_fast>);
+static_assert(!stream_selectable_generator<std::mt19937_64>);
+static_assert(!advanceable_generator<std::mt19937_64>);
+
+constexpr std::size_t NUM_WORDS = 1 << 15;
+
+// Inserts the next NUM_WORDS words of gen into words and reports whether all of them are new. 
+// Two overlapping streams share all words of the overlap, while 64-bit words of independent 
+// streams practically never collide.
+template<typename RNG>
+bool insert_words(RNG gen, std::unordered_set<std::uint64_t> &words) {
+    for (std::size_t i = 0; i < NUM_WORDS; i++) {
+        if (!words.insert(random_word_64(gen)).second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename RNG>
+class SplitGeneratorTest : public testing::Test {};
+
+using Generators = testing::Types<pcg64, pcg32, pcg64_fast, philox4x64, std::mt19937_64>;
+TYPED_TEST_SUITE(SplitGeneratorTest, Generators);
+
+TYPED_TEST(SplitGeneratorTest, ChildrenDoNotOverlap) {
+    TypeParam gen(1234567);
+    std::unordered_set<std::uint64_t> words;
+    // The parent itself, its children and the children of its first child
+    EXPECT_TRUE(insert_words(gen, words));
+    auto children = split_generators(gen, 16);
+    for (auto &child : children) {
+        EXPECT_TRUE(insert_words(child, words));
+    }
+    for (auto &grandchild : split_generators(children[0], 16)) {
+        EXPECT_TRUE(insert_words(grandchild, words));
+    }
+}
+
+TYPED_TEST(SplitGeneratorTest, SplittingAgainGivesNewChildren) {
+    TypeParam gen(1234567);
+    std::unordered_set<std::uint64_t> words;
+    EXPECT_TRUE(insert_words(split_generator(gen, 0), words));
+    // Splitting the same generator after it was used and splitting a child with the same index 
+    // as its parent
+    gen();
+    EXPECT_TRUE(insert_words(split_generator(gen, 0), words));
+    EXPECT_TRUE(insert_words(split_generator(split_generator(gen, 0), 0), words));
+}
+
+TYPED_TEST(SplitGeneratorTest, Reproducible) {
+    TypeParam gen(1234567);
+    TypeParam copy = gen;
+    auto child = split_generator(gen, 5);
+    auto replay = split_generator(gen, 5);
+    for (std::size_t i = 0; i < 100; i++) {
+        EXPECT_EQ(child(), replay());
+        // gen is not changed by splitting
+        EXPECT_EQ(copy(), gen());
+    }
+}
+
+// The children of pcg64_fast lie on the same cycle as their parent, their distances can be checked
+TEST(SplitGeneratorDistanceTest, JumpAhead) {
+    pcg64_fast gen(1234567);
+    std::vector<pcg64_fast> engines = split_generators(gen, 16);
+    engines.push_back(gen);
+    for (std::size_t i = 0; i < engines.size(); i++) {
+        for (std::size_t j = 0; j < engines.size(); j++) {
+            if (i != j) {
+                // At least 2^64 steps apart in both directions
+                EXPECT_GE(engines[i] - engines[j], static_cast<__uint128_t>(1) << 64);
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <cip_shuffle.hpp>
+#include <xoshiro_simd.hpp>
+
+//-------------------------------------------------------------------------------------------------
+
+// Output of the reference implementation of xoshiro256++ for the state {1, 2, 3, 4}
+const std::vector<std::uint64_t> reference_output = {
+    41943041ULL, 58720359ULL, 3588806011781223ULL, 3591011842654386ULL, 9228616714210784205ULL,
+    9973669472204895162ULL, 14011001112246962877ULL, 12406186145184390807ULL, 15849039046786891736ULL,
+    10450023813501588000ULL
+};
+
+template<std::size_t LANES>
+void expect_reference_output_in_lane_0() {
+    auto gen = xoshiro256pp_simd<LANES>::from_state({1, 2, 3, 4});
+    for (std::size_t k = 0; k < reference_output.size(); k++) {
+        for (std::size_t l = 0; l < LANES; l++) {
+            std::uint64_t x = gen();
+            if (l == 0) {
+                EXPECT_EQ(reference_output[k], x) << k;
+            }
+        }
+    }
+}
+
+TEST(XoshiroSimdTest, ReferenceOutput) {
+    expect_reference_output_in_lane_0<1>();
+    expect_reference_output_in_lane_0<4>();
+    expect_reference_output_in_lane_0<8>();
+    expect_reference_output_in_lane_0<12>();
+    expect_reference_output_in_lane_0<16>();
+}
+
+TEST(XoshiroSimdTest, FillMatchesSingleCalls) {
+    xoshiro256pp_simd<8> a(42);
+    xoshiro256pp_simd<8> b(42);
+
+    std::vector<std::uint64_t> expected(1000);
+    for (auto &x : expected) {
+        x = a();
+    }
+
+    std::vector<std::uint64_t> filled(1000);
+    std::size_t pos = 0;
+    for (std::size_t n : {3, 8, 0, 17, 1, 256, 5}) {
+        b.fill(filled.data() + pos, n);
+        pos += n;
+    }
+    filled[pos] = b();
+    pos++;
+    b.fill(filled.data() + pos, filled.size() - pos);
+
+    EXPECT_EQ(expected, filled);
+}
+
+TEST(XoshiroSimdTest, LanesDiffer) {
+    xoshiro256pp_simd<8> gen(7);
+    std::array<std::uint64_t, 8> first;
+    gen.fill(first.data(), first.size());
+    std::sort(first.begin(), first.end());
+    EXPECT_EQ(first.end(), std::adjacent_find(first.begin(), first.end()));
+}
+
+TEST(XoshiroSimdTest, ShufflesArePermutations) {
+    auto gen = seeded_generator<xoshiro256pp_simd<>>(20240101);
+    for (std::size_t size : {10, 1000, 100000}) {
+        std::vector<std::size_t> V(size);
+        std::iota(V.begin(), V.end(), 0);
+        inplace_scatter_shuffle(std::span {V}, gen);
+        std::sort(V.begin(), V.end());
+        for (std::size_t i = 0; i < size; i++) {
+            ASSERT_EQ(i, V[i]);
+        }
+    }
+}